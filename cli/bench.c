@@ -0,0 +1,313 @@
+#include "bench.h"
+#include "printf.h"
+#include "../kernel/timer.h"
+#include "../kernel/dlog.h"
+#include "../kernel/console.h"
+#include "../kernel/iocore.h"
+#include "../kernel/string.h"
+
+// Keeps the compiler from dropping the benchmarked work
+static volatile char benchSink;
+
+// Reference: one division per digit, the way itoa used to work
+static char *naive_dec(uint64_t num, char *end) {
+  do {
+    *--end = '0' + (char)(num % 10);
+    num /= 10;
+  } while (num);
+  return end;
+}
+
+typedef struct {
+  const char *label;
+  const char *format;
+  unsigned long value;
+} FormatCase;
+
+static const FormatCase formatCases[] = {
+  {"%lu small", "%lu", 7},
+  {"%lu 10 digits", "%lu", 1234567890UL},
+  {"%lu 20 digits", "%lu", 18446744073709551615UL},
+  {"%lx 16 digits", "%lx", 0xFEDCBA9876543210UL},
+  {"%b 32 digits", "%b", 0xFFFFFFFFUL},
+};
+
+typedef struct {
+  const char *label;
+  const char *format;
+  double value;
+} FloatCase;
+
+static const FloatCase floatCases[] = {
+  {"%f pi", "%f", 3.141592653589793},
+  {"%e avogadro", "%e", 6.02214076e23},
+  {"%g 1/3", "%g", 1.0 / 3.0},
+};
+
+/**
+ * Cycles per integer conversion, raw conversion and through snprintf
+ */
+void benchFormat(int argc, char **argv) {
+  char buffer[INT_BUFFER_SIZE];
+  char *end = buffer + INT_BUFFER_SIZE;
+
+  printf("\n%s %20c %s\n", "case", ' ', "cycles/conversion");
+  for (size_t i = 0; i < sizeof(formatCases) / sizeof(FormatCase); i++) {
+    const FormatCase *fc = &formatCases[i];
+    unsigned long start = cycles();
+
+    for (int n = 0; n < BENCH_ITERATIONS; n++) {
+      snprintf(buffer, sizeof(buffer), fc->format, fc->value);
+      benchSink = buffer[0];
+    }
+    printf("snprintf %s %10c %.2f\n", fc->label, ' ', (double)(cycles() - start) / BENCH_ITERATIONS);
+  }
+
+  for (size_t i = 0; i < sizeof(floatCases) / sizeof(FloatCase); i++) {
+    const FloatCase *fc = &floatCases[i];
+    unsigned long start = cycles();
+
+    for (int n = 0; n < BENCH_ITERATIONS; n++) {
+      snprintf(buffer, sizeof(buffer), fc->format, fc->value);
+      benchSink = buffer[0];
+    }
+    printf("snprintf %s %10c %.2f\n", fc->label, ' ', (double)(cycles() - start) / BENCH_ITERATIONS);
+  }
+
+  unsigned long start = cycles();
+  for (int n = 0; n < BENCH_ITERATIONS; n++) {
+    benchSink = *utoa_dec(18446744073709551615UL - n, end);
+  }
+  printf("utoa_dec 20 digits %14c %.2f\n", ' ', (double)(cycles() - start) / BENCH_ITERATIONS);
+
+  start = cycles();
+  for (int n = 0; n < BENCH_ITERATIONS; n++) {
+    benchSink = *naive_dec(18446744073709551615UL - n, end);
+  }
+  printf("per-digit division 20 digits %4c %.2f\n", ' ', (double)(cycles() - start) / BENCH_ITERATIONS);
+
+  // the same line parsed at run time and walked from its build-time program
+  start = cycles();
+  for (int n = 0; n < BENCH_ITERATIONS; n++) {
+    snprintf(buffer, sizeof(buffer), FMT_BENCH_LINE, 0x80000UL + n, n, "ok", (unsigned long)n);
+    benchSink = buffer[0];
+  }
+  printf("snprintf runtime parse %10c %.2f\n", ' ', (double)(cycles() - start) / BENCH_ITERATIONS);
+
+  start = cycles();
+  for (int n = 0; n < BENCH_ITERATIONS; n++) {
+    SNPRINTF_FMT(buffer, sizeof(buffer), BENCH_LINE, 0x80000UL + n, n, "ok", (unsigned long)n);
+    benchSink = buffer[0];
+  }
+  printf("snprintf pre-parsed %13c %.2f\n", ' ', (double)(cycles() - start) / BENCH_ITERATIONS);
+
+  char digits[DTOA_DIGITS_MAX];
+  int exp10;
+  start = cycles();
+  for (int n = 0; n < BENCH_ITERATIONS; n++) {
+    dtoa_shortest(3.141592653589793 + n, digits, &exp10);
+    benchSink = digits[0];
+  }
+  printf("dtoa_shortest 16 digits %9c %.2f\n", ' ', (double)(cycles() - start) / BENCH_ITERATIONS);
+}
+
+// Records per run, small enough to fit the dlog ring
+#define BENCH_DLOG_RECORDS 100
+
+/**
+ * Deferred record vs formatted text: caller cycles and bytes per line
+ */
+void benchDlog(int argc, char **argv) {
+  char buffer[128];
+  unsigned long textBytes = 0;
+  unsigned long bytesBefore = dlogStats.bytes;
+
+  unsigned long start = cycles();
+  for (int n = 0; n < BENCH_DLOG_RECORDS; n++) {
+    textBytes += snprintf(buffer, sizeof(buffer), "sensor %u reading %d at %x", n, -3 * n, 0x80000 + n);
+  }
+  unsigned long textCycles = cycles() - start;
+
+  start = cycles();
+  for (int n = 0; n < BENCH_DLOG_RECORDS; n++) {
+    DLOG("sensor %u reading %d at %x", n, -3 * n, 0x80000 + n);
+  }
+  unsigned long dlogCycles = cycles() - start;
+  unsigned long dlogBytes = dlogStats.bytes - bytesBefore;
+
+  printf("\n%s %10c %s %5c %s\n", "method", ' ', "cycles/line", ' ', "bytes/line");
+  printf("snprintf %8c %.2f %9c %.2f\n", ' ', (double)textCycles / BENCH_DLOG_RECORDS, ' ', (double)textBytes / BENCH_DLOG_RECORDS);
+  printf("DLOG %12c %.2f %9c %.2f\n", ' ', (double)dlogCycles / BENCH_DLOG_RECORDS, ' ', (double)dlogBytes / BENCH_DLOG_RECORDS);
+}
+
+// Lines per run, fits the console lane and the record ring
+#define BENCH_PRINTF_LINES 16
+
+/**
+ * Caller-side cycles per line: synchronous printf vs a record queued for the I/O core
+ */
+void benchPrintf(int argc, char **argv) {
+  int viaLane = iocore_running();
+  IoCoreStats before, after;
+
+  printf("\n");
+  unsigned long start = cycles();
+  for (int n = 0; n < BENCH_PRINTF_LINES; n++) {
+    printf("sync line %d value %x\n", n, n * 3);
+  }
+  unsigned long syncCycles = cycles() - start;
+  console_flush();
+
+  if (!iocore_start()) {
+    printf("I/O core %d didn't start\n", IOCORE_CORE);
+    return;
+  }
+
+  iocore_stats(&before);
+  start = cycles();
+  for (int n = 0; n < BENCH_PRINTF_LINES; n++) {
+    aprintf("async line %d value %x\n", n, n * 3);
+  }
+  unsigned long asyncCycles = cycles() - start;
+  iocore_wait_idle(1000);
+  iocore_stats(&after);
+
+  printf("\n%s %17c %s\n", "method", ' ', "caller cycles/line");
+  printf("%s %c %.2f\n", viaLane ? "printf (line to I/O core)" : "printf (formats, drives UART)", ' ',
+         (double)syncCycles / BENCH_PRINTF_LINES);
+  printf("aprintf (record to I/O core) %c %.2f\n", ' ', (double)asyncCycles / BENCH_PRINTF_LINES);
+  printf("records dropped %c %lu\n", ':', after.dropped - before.dropped);
+}
+
+// String lengths measured by bench_string
+static const int stringLengths[] = {1, 8, 16, 64, 256, 1024};
+#define BENCH_STRING_MAX 1024
+
+/**
+ * Cycles per call for strlen, strchr and strcmp against their byte at a time versions
+ */
+void benchString(int argc, char **argv) {
+  static char str1[BENCH_STRING_MAX + 1] __attribute__((aligned(16)));
+  static char str2[BENCH_STRING_MAX + 1] __attribute__((aligned(16)));
+
+  printf("\n%s %5c %s %8c %s %8c %s\n", "length", ' ', "strlen", ' ', "strchr", ' ', "strcmp");
+  for (size_t i = 0; i < sizeof(stringLengths) / sizeof(int); i++) {
+    int len = stringLengths[i];
+    double perCall[2][3];
+
+    for (int n = 0; n < len; n++) {
+      str1[n] = str2[n] = 'a' + n % 26;
+    }
+    str1[len] = str2[len] = '\0';
+    str1[len - 1] = str2[len - 1] = '#';  // strchr target, last byte
+
+    for (int scalar = 0; scalar < 2; scalar++) {
+      unsigned long start = cycles();
+      for (int n = 0; n < BENCH_ITERATIONS; n++) {
+        benchSink = (char)(scalar ? strlen_scalar(str1) : strlen(str1));
+      }
+      perCall[scalar][0] = (double)(cycles() - start) / BENCH_ITERATIONS;
+
+      start = cycles();
+      for (int n = 0; n < BENCH_ITERATIONS; n++) {
+        benchSink = *(scalar ? strchr_scalar(str1, '#') : strchr(str1, '#'));
+      }
+      perCall[scalar][1] = (double)(cycles() - start) / BENCH_ITERATIONS;
+
+      start = cycles();
+      for (int n = 0; n < BENCH_ITERATIONS; n++) {
+        benchSink = (char)(scalar ? strcmp_scalar(str1, str2) : strcmp(str1, str2));
+      }
+      perCall[scalar][2] = (double)(cycles() - start) / BENCH_ITERATIONS;
+    }
+
+    printf("%6d   %6.1f/%.1f   %6.1f/%.1f   %6.1f/%.1f\n", len,
+           perCall[0][0], perCall[1][0], perCall[0][1], perCall[1][1], perCall[0][2], perCall[1][2]);
+  }
+  printf("cycles per call, vector/byte at a time\n");
+}
+
+// Copy sizes measured by bench_mem
+static const int memSizes[] = {8, 64, 256, 1024, 4096};
+#define BENCH_MEM_MAX 4096
+
+// Reference: one byte per iteration
+static void byte_copy(char *dest, const char *src, size_t n) {
+  while (n--) {
+    *dest++ = *src++;
+  }
+}
+
+/**
+ * Cycles per call for memcpy (aligned and misaligned source), overlapping
+ * memmove and memset, against a byte loop
+ */
+void benchMem(int argc, char **argv) {
+  static char src[BENCH_MEM_MAX + 64] __attribute__((aligned(64)));
+  static char dest[BENCH_MEM_MAX + 64] __attribute__((aligned(64)));
+
+  printf("\n%s %3c %s %3c %s %3c %s %3c %s %3c %s\n", "size", ' ', "byte loop", ' ', "memcpy", ' ',
+         "memcpy src+3", ' ', "memmove", ' ', "memset");
+  for (size_t i = 0; i < sizeof(memSizes) / sizeof(int); i++) {
+    int n = memSizes[i];
+    double perCall[5];
+
+    for (int k = 0; k < 5; k++) {
+      unsigned long start = cycles();
+      for (int r = 0; r < BENCH_ITERATIONS; r++) {
+        switch (k) {
+        case 0: byte_copy(dest, src, n); break;
+        case 1: memcpy(dest, src, n); break;
+        case 2: memcpy(dest, src + 3, n); break;
+        case 3: memmove(dest + 8, dest, n); break;  // overlapping, copies backwards
+        case 4: memset(dest, 0, n); break;
+        }
+        benchSink = dest[n - 1];
+      }
+      perCall[k] = (double)(cycles() - start) / BENCH_ITERATIONS;
+    }
+
+    printf("%4d %3c %9.1f %3c %6.1f %3c %12.1f %3c %7.1f %3c %6.1f\n", n, ' ', perCall[0], ' ', perCall[1], ' ',
+           perCall[2], ' ', perCall[3], ' ', perCall[4]);
+  }
+  printf("cycles per call\n");
+}
+
+// Haystack size for bench_search
+#define BENCH_SEARCH_SIZE 16384
+
+// Needles: absent, near misses on a repeated prefix, long, at the very end
+static const char *searchNeedles[] = {"zq", "uart0 tx", "boot 7 mailbox call failed", "dma"};
+
+/**
+ * Cycles per KB of haystack for strstr against the naive byte-by-byte search
+ */
+void benchSearch(int argc, char **argv) {
+  static char haystack[BENCH_SEARCH_SIZE + 1] __attribute__((aligned(16)));
+  static const char words[] = "uart0 rx mailbox boot call data ";
+  const int runs = 10;
+
+  for (int i = 0; i < BENCH_SEARCH_SIZE; i++) {
+    haystack[i] = words[i % (sizeof(words) - 1)];
+  }
+  haystack[BENCH_SEARCH_SIZE - 3] = 'd';
+  haystack[BENCH_SEARCH_SIZE - 2] = 'm';
+  haystack[BENCH_SEARCH_SIZE - 1] = 'a';
+  haystack[BENCH_SEARCH_SIZE] = '\0';
+
+  printf("\n%s %26c %s %5c %s\n", "needle", ' ', "strstr", ' ', "naive");
+  for (size_t i = 0; i < sizeof(searchNeedles) / sizeof(searchNeedles[0]); i++) {
+    double perKb[2];
+
+    for (int naive = 0; naive < 2; naive++) {
+      unsigned long start = cycles();
+      for (int r = 0; r < runs; r++) {
+        char *hit = naive ? strstr_scalar(haystack, searchNeedles[i]) : strstr(haystack, searchNeedles[i]);
+        benchSink = hit ? *hit : 0;
+      }
+      perKb[naive] = (double)(cycles() - start) / runs / (BENCH_SEARCH_SIZE / 1024);
+    }
+    printf("%32s %9.1f %9.1f\n", searchNeedles[i], perKb[0], perKb[1]);
+  }
+  printf("cycles per KB searched\n");
+}
@@ -0,0 +1,15 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+// Number of repetitions per measured case
+#define BENCH_ITERATIONS 1000
+
+// Benchmark commands
+void benchFormat(int argc, char **argv);
+void benchDlog(int argc, char **argv);
+void benchPrintf(int argc, char **argv);
+void benchString(int argc, char **argv);
+void benchMem(int argc, char **argv);
+void benchSearch(int argc, char **argv);
+
+#endif
@@ -1,39 +1,56 @@
 #include "cli.h"
 #include "command.h"
 #include "printf.h"
-#include "../uart/uart0.h"
+#include "../uart/uart.h"
 #include "../kernel/mbox.h"
 #include "../kernel/string.h"
+#include "../kernel/dlog.h"
+#include "../kernel/console.h"
+#include "../kernel/containers.h"
 
 #define MAX_CMD_SIZE 100
-#define MAX_HISTORY 20
+#define MAX_HISTORY 32  // power of two, the oldest line is dropped when full
 
-char commandHistory[MAX_HISTORY][MAX_CMD_SIZE];
-int lastCommandIndex = 0;
-int historyIndex = 0;
+typedef struct {
+  char text[MAX_CMD_SIZE];
+} HistoryLine;
+
+RING_DEFINE(History, HistoryLine, MAX_HISTORY)
+
+History commandHistory;    // zeroed in .bss, i.e. empty
+uint32_t historyIndex = 0;  // line shown while browsing, the count when on a new line
 
 extern volatile unsigned int mBuf[];
 
 void processCommand(char *command){
-  // seperate the commands and arguements
-  char *commandName = strtok(command, " ");
-  char *args = strtok(NULL, "");
-  for (size_t i = 0; i < sizeof(commandList) / sizeof(Command); i++)
-  {
-    if (strcmp(commandName, commandList[i].name) == 0){
-      printf("\n");
-      commandList[i].handler(args);
-      return;
-    }
+  // split the line in place, argv[0] is the command name
+  char *argv[CLI_MAX_ARGS];
+  int argc = strsplit(command, " ", argv, CLI_MAX_ARGS);
+
+  if (argc == 0) {
+    return;  // blank line
   }
-  printf("\nCommand not found: %s. Please use help to view all valid commands.", commandName);
+  if (argc < 0) {
+    printf("\nToo many arguments, a command takes at most %d.", CLI_MAX_ARGS - 1);
+    return;
+  }
+
+  Command *cmd = findCommand(argv[0]);
+  if (cmd && cmd->handler){
+    printf("\n");
+    cmd->handler(argc, argv);
+    return;
+  }
+  printf("\nCommand not found: %s. Please use help to view all valid commands.", argv[0]);
 }
 
 void autocompleteHandler(char *buffer, int *index)
 {
-  // For simplicity, autocomplete with the first matching command
+  size_t len = strlen(buffer);
+
+  // For simplicity, autocomplete with the first command the buffer is a prefix of
   for (int i = 0; i < sizeof(commandList) / sizeof(Command); i++){
-    if (strstr(commandList[i].name, buffer) == commandList[i].name){
+    if (strlen(commandList[i].name) >= len && memcmp(commandList[i].name, buffer, len) == 0){
       // found a match, complete the buffer
       strcpy(buffer, commandList[i].name);
       *index = strlen(buffer);
@@ -53,6 +70,10 @@ void cli_main() {
     isNewCommand = 0;
   }
 
+  // push buffered console text and deferred log records out before waiting for input
+  console_flush();
+  dlog_flush();
+
   char c = uart_getc();
 
   // Detecting the beginning of an escape sequence (for handling arrow keys) 
@@ -66,7 +87,7 @@ void cli_main() {
       case 'A':
         if (historyIndex > 0) {
           historyIndex--;
-          strcpy(cli_buffer, commandHistory[historyIndex]);
+          strcpy(cli_buffer, History_at(&commandHistory, historyIndex)->text);
           printf("\rMyBareOS> %s", cli_buffer);
           index = strlen(cli_buffer);
         }
@@ -74,13 +95,13 @@ void cli_main() {
 
       // Down arrow
       case 'B':
-        if (historyIndex < lastCommandIndex - 1) {
+        if (historyIndex + 1 < History_count(&commandHistory)) {
             historyIndex++;
-            strcpy(cli_buffer, commandHistory[historyIndex]);
+            strcpy(cli_buffer, History_at(&commandHistory, historyIndex)->text);
             printf("\rMyBareOS> %s", cli_buffer);
             index = strlen(cli_buffer);
         } 
-        else if (historyIndex == lastCommandIndex - 1) {
+        else if (historyIndex + 1 == History_count(&commandHistory)) {
             historyIndex++;
             cli_buffer[0] = '\0'; // clear buffer to allow new command entry
             printf("\rMyBareOS> ");
@@ -112,9 +133,10 @@ void cli_main() {
       case '\n':
         cli_buffer[index] = '\0';
         if (index > 0) {  // Only save non-empty commands
-          strcpy(commandHistory[historyIndex % MAX_HISTORY], cli_buffer);
-          lastCommandIndex = (lastCommandIndex + 1) % MAX_HISTORY;
-          historyIndex = lastCommandIndex;
+          HistoryLine line;
+          strcpy(line.text, cli_buffer);
+          History_push_over(&commandHistory, &line);
+          historyIndex = History_count(&commandHistory);
         }
         processCommand(cli_buffer);
         isNewCommand = 1;
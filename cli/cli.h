@@ -2,7 +2,10 @@
 #define CLI_H
 
 // Function type for command handlers
-typedef void (*CommandFunction)(char *args);
+typedef void (*CommandFunction)(int argc, char **argv);
+
+// Most words a command line splits into, the command name included
+#define CLI_MAX_ARGS 16
 
 // Declarations
 void processCommand(char *command);
@@ -1,8 +1,19 @@
 #include "command.h"
 #include "printf.h"
+#include "bench.h"
+#include "../uart/uart.h"
 #include "../uart/uart0.h"
 #include "../kernel/mbox.h"
 #include "../kernel/string.h"
+#include "../kernel/timer.h"
+#include "../kernel/dlog.h"
+#include "../kernel/log.h"
+#include "../kernel/console.h"
+#include "../kernel/plog.h"
+#include "../kernel/crc32.h"
+#include "../kernel/gpio.h"
+#include "../kernel/page_alloc.h"
+#include "../kernel/slab.h"
 
 extern volatile unsigned int mBuf[];
 
@@ -18,7 +29,24 @@ Command commandList[] = {
   {"set_databits", "Set number of data bits configuration to 5, 6, 7, or 8.\nExample: MyBareOS> set_databits 7", setDataBits},
   {"set_stopbits", "Set stop bits configuration to 1 or 2.\nExample: ", setStopBits},
   {"set_parity", "Set parity configuration to one of the following: NONE, EVEN, ODD.\nExample: MyBareOS> set_parity odd", setParity},
-  {"set_handshaking", "Set CTS/RTS handshaking to ON or OFF.\nExample: MyBareOS> set_handshaking on", setHandshaking},
+  {"set_handshaking", "Set CTS/RTS handshaking to ON or OFF, or use XONXOFF software flow control. The host is throttled when the receive ring is 3/4 full and resumed at 1/4.\nExample: MyBareOS> set_handshaking on", setHandshaking},
+  {"set_port", "Show or select the serial port used for the console or the log/trace stream: 0 = PL011, 1 = mini UART.\nExample: MyBareOS> set_port log 1", selectPort},
+  {"set_fifo", "Show how often the PL011 was polled with RX data ready and waited on a full TX FIFO, or set its RX and TX FIFO trigger levels to 1/8, 1/4, 1/2, 3/4 or 7/8 (resets the statistics).\nExample: MyBareOS> set_fifo 7/8 1/8", setFifoLevels},
+  {"uartstat", "Show per-port UART byte, error and stall counters, or reset them.\nExample: MyBareOS> uartstat reset", showUartStats},
+  {"bench_fmt", "Measure CPU cycles per conversion for decimal, hex, binary and floating point formatting.\nExample: MyBareOS> bench_fmt", benchFormat},
+  {"dlog", "Show deferred binary log statistics, or flush the queued records to the log port. Decode the log port with tools/dlog_decode.py.\nExample: MyBareOS> dlog flush", showDlog},
+  {"bench_printf", "Compare the caller's cycles per line for printf against aprintf, which queues the arguments for the I/O core (core 3) to format. The first run hands the console to the I/O core.\nExample: MyBareOS> bench_printf", benchPrintf},
+  {"bench_string", "Compare cycles per call of the vectorized strlen, strchr and strcmp against byte at a time loops, over strings from 1 to 1024 bytes.\nExample: MyBareOS> bench_string", benchString},
+  {"bench_mem", "Compare cycles per call of memcpy, memmove and memset against a byte loop, for 8 to 4096 bytes.\nExample: MyBareOS> bench_mem", benchMem},
+  {"bench_search", "Compare cycles per KB of strstr (NEON first-byte prefilter or Horspool) against the naive byte-by-byte search, over a 16KB text.\nExample: MyBareOS> bench_search", benchSearch},
+  {"bench_dlog", "Compare cycles and bytes of a deferred binary log record against formatting the same line with snprintf.\nExample: MyBareOS> bench_dlog", benchDlog},
+  {"logmask", "Show which modules may log, or turn logging on or off for one module or all of them. Levels below the build's LOG_LEVEL are compiled out.\nExample: MyBareOS> logmask mbox off", setLogMask},
+  {"console", "Show the console sinks, set a sink's buffering to line, full or none, or turn it on or off.\nExample: MyBareOS> console uart full", showConsole},
+  {"dmesg", "Print the persistent log, which keeps console output across warm resets. Only lines containing the filter text are shown, -c clears the log after printing.\nExample: MyBareOS> dmesg -c mbox", showDmesg},
+  {"crc32", "Compute the CRC-32 and CRC-32C of a memory range and report the throughput. The address and length take decimal or 0x hex, the length also a K or M suffix. The range must end below the peripherals.\nExample: MyBareOS> crc32 0x80000 256K", checksumMemory},
+  {"pages", "Show the page allocator's managed range and its free blocks of each order, 4KB to 2MB.\nExample: MyBareOS> pages", showPages},
+  {"meminfo", "Show page and kmalloc usage: free memory and how much of it is still in 2MB blocks, then per size class the slabs, objects in use and cached in the per-core magazines, and the allocation rates since the last meminfo.\nExample: MyBareOS> meminfo", showMemInfo},
+  {"switch_baud", "Negotiate a new baud rate with a host tool (tools/baudswitch.py). Falls back to 115200 if the probe pattern isn't received.\nExample: MyBareOS> switch_baud 921600", switchBaudRate},
 };
 
 // Instantiate the colors
@@ -33,59 +61,16 @@ ColorMap colorMappings[] = {
   {"white", "\033[1;37m", "\x1b[47m"}
 };
 
-unsigned long strtoul(const char *str, char **endptr, int base){
-  unsigned long result = 0;
-  while (*str){
-    if (*str >= '0' && *str <= '9'){
-      result = result * base + *str - '0';
-    }
-    else if (*str >= 'A' && *str <= 'Z'){
-      result = result * base + *str - 'A' + 10;
-    }
-    else if (*str >= 'a' && *str <= 'z'){
-      result = result * base + *str - 'a' + 10;
-    }
-    else{
-      break;
-    }
-    str++;
-  }
-  if (endptr){
-    *endptr = (char *)str;
-  }
-  return result;
-}
-
-const char *findTextColor(const char *colorStr){
-  for (size_t i = 0; i < sizeof(colorMappings) / sizeof(ColorMap); i++){
-    if (strcmp(colorStr, colorMappings[i].colorName) == 0){
-      return colorMappings[i].textColorAscii;
-    }
-  }
-  return NULL; // Not found
-}
-
-const char *findAsciiBgColor(const char *colorStr){
-  for (size_t i = 0; i < sizeof(colorMappings) / sizeof(ColorMap); i++){
-    if (strcmp(colorStr, colorMappings[i].colorName) == 0){
-      return colorMappings[i].bgColorAscii;
-    }
-  }
-  return NULL; // Not found
-}
-
-void displayAllCommands(char *args)
+void displayAllCommands(int argc, char **argv)
 {
-  // check if the arg and its value is not null
-  if (args && *args){
-    for (size_t i = 0; i < sizeof(commandList) / sizeof(Command); i++){
-      // check if the command name is equal to the arg
-      if (strcmp(args, commandList[i].name) == 0){
-        printf("--%s: \n%s\n", commandList[i].name, commandList[i].description);
-        return;
-      }
+  // check if a command name was given
+  if (argc > 1){
+    Command *cmd = findCommand(argv[1]);
+    if (cmd){
+      printf("--%s: \n%s\n", cmd->name, cmd->description);
+      return;
     }
-    printf("\nCommand '%s' not found.\n", args); // If no command matched
+    printf("\nCommand '%s' not found.\n", argv[1]); // If no command matched
   }
   // Display all commands if no specific command name is provided
   else{
@@ -96,19 +81,19 @@ void displayAllCommands(char *args)
   }
 }
 
-void clearScreen(char *args){
+void clearScreen(int argc, char **argv){
   printf("\033[2J\033[1;1H");
 }
 
-void setConsoleColor(char *args)
+void setConsoleColor(int argc, char **argv)
 {
-  char *token = strtok(args, " ");
-  while (token)
+  for (int i = 1; i < argc; i++)
   {
     const char *asciiColor = NULL;
-    printf("\n%s", token);
+    char *token = argv[i];
+    LOG_DEBUG(LOG_MOD_CLI, "setcolor token %s", token);
     if (strcmp(token, "-t") == 0){
-      token = strtok(NULL, " ");
+      token = ++i < argc ? argv[i] : NULL;
       
       if (token){
         asciiColor = findTextColor(token); // retrieve the color input
@@ -122,7 +107,7 @@ void setConsoleColor(char *args)
       }
     }
     else if (strcmp(token, "-b") == 0){
-      token = strtok(NULL, " ");
+      token = ++i < argc ? argv[i] : NULL;
       
       if (token){
         asciiColor = findAsciiBgColor(token);
@@ -136,11 +121,10 @@ void setConsoleColor(char *args)
         }
       }
     }
-      token = strtok(NULL, " ");
   }
 }
 
-void displayBoardInfo(char *args){
+void displayBoardInfo(int argc, char **argv){
   unsigned int *response = 0;
   // display board model
   mbox_buffer_setup(ADDR(mBuf), MBOX_TAG_GETMODEL, &response, 4, 0);
@@ -172,70 +156,516 @@ void displayBoardInfo(char *args){
   // display ARM memory
   mbox_buffer_setup(ADDR(mBuf), MBOX_TAG_ARM_MEMORY, &response, 4, 0);
   mbox_call(ADDR(mBuf), MBOX_CH_PROP);
-  printf("ARM memory %17c %dMB\n", ':', response[0] / 10485760); // convert to megabytes
+  printf("ARM memory %17c %.9gMB\n", ':', response[1] / 1048576.0); // size in bytes follows the base address
   
   // display VC memory
   mbox_buffer_setup(ADDR(mBuf), MBOX_TAG_VC_MEMORY, &response, 8, 0);
   mbox_call(ADDR(mBuf), MBOX_CH_PROP);
-  printf("VC memory %18c %dMB\n", ':', response[0] / 10485760); // convert to megabytes
+  printf("VC memory %18c %.9gMB\n", ':', response[1] / 1048576.0); // size in bytes follows the base address
 
   // display clock rate of arm
   mbox_buffer_setup(ADDR(mBuf), MBOX_TAG_GETCLKRATE, &response, 8, 0, 3);
   mbox_call(ADDR(mBuf), MBOX_CH_PROP);
-  printf("ARM clock rate %13c %dMHz\n", ':', response[0] / 1000000); // convert to MH
+  printf("ARM clock rate %13c %.9gMHz\n", ':', response[0] / 1000000.0); // convert Hz to MHz
 
   // display clock rate of uart
   mbox_buffer_setup(ADDR(mBuf), MBOX_TAG_GETCLKRATE, &response, 8, 0, 2);
   mbox_call(ADDR(mBuf), MBOX_CH_PROP);
-  printf("UART clock rate %12c %dMHz\n", ':', response[0] / 1000000); // convert to MH
+  printf("UART clock rate %12c %.9gMHz\n", ':', response[0] / 1000000.0); // convert Hz to MHz
 }
 
-void setBaudRate(char *args) {
-  unsigned int baudRate = strtoul(args, NULL, 10);
-  uart_set_baud_rate(baudRate);
-  uart_puts("\nBaud rate updated.\n");
+void setBaudRate(int argc, char **argv) {
+  unsigned int baudRate = argc > 1 ? strtoul(argv[1], NULL, 10) : 0;
+  if (!uart_set_baud_rate(baudRate)) {
+    printf("\nInvalid baud rate.\n");
+    return;
+  }
+  printf("\nBaud rate updated.\n");
 }
 
-void setDataBits(char *args) {
-  if(strcmp(args, "5") != 0 && strcmp(args, "6") != 0 && strcmp(args, "7") != 0 && strcmp(args, "8") != 0) {
-    uart_puts("\nInvalid data bits setting. Use '5', '6', '7', or '8'.\n");
+// Probe pattern sent by the host at the new rate, alternating bits catch divisor errors
+static const char baudProbe[] = {0x55, 0xAA, 0x0F, 0xF0, 'P', 'R', 'O', 'B', 'E'};
+#define BAUD_PROBE_TIMEOUT_MS 2000
+#define BAUD_CONFIRM_TIMEOUT_MS 1000
+
+// Wait for the probe pattern, skipping any line noise in front of it
+static int receiveBaudProbe() {
+  unsigned long start = timer_ticks();
+  unsigned long wait = (timer_freq() * BAUD_PROBE_TIMEOUT_MS) / 1000;
+  size_t matched = 0;
+  char c;
+
+  while (matched < sizeof(baudProbe)) {
+    if (timer_ticks() - start >= wait || !uart_getc_timeout(&c, BAUD_PROBE_TIMEOUT_MS)) {
+      return 0;
+    }
+    if (c == baudProbe[matched]) {
+      matched++;
+    }
+    else {
+      matched = (c == baudProbe[0]) ? 1 : 0;
+    }
+  }
+  return 1;
+}
+
+/*
+ * Handshake:
+ *  host  -> "switch_baud <rate>"      (old rate)
+ *  board -> "ACK <rate>" or "NAK"     (old rate)
+ *  host  -> probe pattern             (new rate)
+ *  board -> probe pattern echoed      (new rate)
+ *  host  -> "OK"                      (new rate)
+ * Either side falls back to 115200 if a step times out.
+ */
+void switchBaudRate(int argc, char **argv) {
+  unsigned int baudRate = argc > 1 ? strtoul(argv[1], NULL, 10) : 0;
+  unsigned int oldRate = uart_get_baud_rate();
+  char c;
+
+  if (!uart_baud_supported(baudRate)) {
+    printf("NAK\n");
+    console_flush();
     return;
   }
 
-  unsigned char dataBits = (unsigned char)strtoul(args, NULL, 10);
-  uart_set_data_bits(dataBits);
-  uart_puts("\nData bits setting updated.\n");
+  printf("ACK %u\n", baudRate);
+  console_flush();
+
+  // if the backend can't generate the rate the probe never matches and we fall back
+  if (uart_set_baud_rate(baudRate) && receiveBaudProbe()) {
+    for (size_t i = 0; i < sizeof(baudProbe); i++) {
+      uart_sendc(baudProbe[i]);
+    }
+    // the echo has to be on the wire at the new rate before the host answers
+    console_sync();
+
+    if (uart_getc_timeout(&c, BAUD_CONFIRM_TIMEOUT_MS) && c == 'O' &&
+        uart_getc_timeout(&c, BAUD_CONFIRM_TIMEOUT_MS) && c == 'K') {
+      DLOG("baud switched %u -> %u", oldRate, baudRate);
+      printf("\nBaud rate switched from %d to %d.\n", oldRate, baudRate);
+      return;
+    }
+  }
+
+  uart_set_baud_rate(UART_BAUD_DEFAULT);
+  DLOG("baud switch to %u failed", baudRate);
+  printf("\nBaud switch to %d failed, reverted to %d.\n", baudRate, UART_BAUD_DEFAULT);
 }
 
-void setStopBits(char *args) {
-  unsigned char stop_bits = (unsigned char)strtoul(args, NULL, 10);
+void setDataBits(int argc, char **argv) {
+  const char *bits = argc > 1 ? argv[1] : "";
+  if(strcmp(bits, "5") != 0 && strcmp(bits, "6") != 0 && strcmp(bits, "7") != 0 && strcmp(bits, "8") != 0) {
+    printf("\nInvalid data bits setting. Use '5', '6', '7', or '8'.\n");
+    return;
+  }
+
+  unsigned char dataBits = (unsigned char)strtoul(bits, NULL, 10);
+  if (!uart_set_data_bits(dataBits)) {
+    printf("\nThis data bits setting isn't supported on the console port.\n");
+    return;
+  }
+  printf("\nData bits setting updated.\n");
+}
+
+void setStopBits(int argc, char **argv) {
+  unsigned char stop_bits = argc > 1 ? (unsigned char)strtoul(argv[1], NULL, 10) : 0;
   if (stop_bits == 1 || stop_bits == 2) {
-    uart_set_stop_bits(stop_bits);
-    uart_puts("\nStop bits setting updated.\n");
+    if (!uart_set_stop_bits(stop_bits)) {
+      printf("\nThis stop bits setting isn't supported on the console port.\n");
+      return;
+    }
+    printf("\nStop bits setting updated.\n");
   } 
   else {
-    uart_puts("\nInvalid stop bits setting. Use '1' or '2'.\n");
+    printf("\nInvalid stop bits setting. Use '1' or '2'.\n");
   }
 }
 
-void setParity(char *args) {
-  if (strcmp(args, "none") == 0 || strcmp(args, "even") == 0 || strcmp(args, "odd") == 0) {
-    uart_set_parity(args);
-    uart_puts("\nParity setting updated.\n");
+void setParity(int argc, char **argv) {
+  char *parity = argc > 1 ? argv[1] : "";
+  if (strcmp(parity, "none") == 0 || strcmp(parity, "even") == 0 || strcmp(parity, "odd") == 0) {
+    if (!uart_set_parity(parity)) {
+      printf("\nThis parity setting isn't supported on the console port.\n");
+      return;
+    }
+    printf("\nParity setting updated.\n");
   } 
   else {
-    uart_puts("\nInvalid parity setting. Use 'none', 'even', or 'odd'.\n");
+    printf("\nInvalid parity setting. Use 'none', 'even', or 'odd'.\n");
   }
 }
 
-void setHandshaking(char *args) {
-  if (strcmp(args, "on") == 0) {
-    uart_enable_handshaking();
+void setHandshaking(int argc, char **argv) {
+  const char *setting = argc > 1 ? argv[1] : "";
+  int mode;
+
+  if (strcmp(setting, "on") == 0) {
+    mode = UART_FLOW_RTSCTS;
+  } 
+  else if (strcmp(setting, "xonxoff") == 0) {
+    mode = UART_FLOW_XONXOFF;
   } 
-  else if (strcmp(args, "off") == 0) {
-    uart_disable_handshaking();
+  else if (strcmp(setting, "off") == 0) {
+    mode = UART_FLOW_NONE;
   } 
   else {
-    uart_puts("\nInvalid handshaking command. Use 'on' or 'off'.\n");
+    printf("\nInvalid handshaking command. Use 'on', 'xonxoff' or 'off'.\n");
+    return;
+  }
+
+  if (!uart_set_flow_control(mode)) {
+    printf("\nThis flow control mode isn't supported on the console port.\n");
+    return;
+  }
+  printf(mode == UART_FLOW_NONE ? "\nHandshaking disabled.\n" : "\nHandshaking enabled.\n");
+}
+
+void selectPort(int argc, char **argv) {
+  char *target = argc > 1 ? argv[1] : NULL;
+  char *portStr = argc > 2 ? argv[2] : NULL;
+
+  if (target && portStr) {
+    int port = (int)strtoul(portStr, NULL, 10);
+    int ok = 0;
+
+    if (strcmp(target, "console") == 0) {
+      ok = uart_select_console(port);
+    }
+    else if (strcmp(target, "log") == 0) {
+      ok = uart_select_log(port);
+    }
+
+    if (!ok) {
+      printf("\nInvalid port selection. Use 'console' or 'log' followed by 0 or 1.\n");
+      return;
+    }
+  }
+
+  printf("\nConsole %5c %s\n", ':', uartPorts[uart_console_port()]->name);
+  printf("Log %9c %s\n", ':', uartPorts[uart_log_port()]->name);
+}
+
+static const char *fifoLevelNames[] = {"1/8", "1/4", "1/2", "3/4", "7/8"};
+
+static int parseFifoLevel(const char *str) {
+  for (int i = 0; i < sizeof(fifoLevelNames) / sizeof(fifoLevelNames[0]); i++) {
+    if (strcmp(str, fifoLevelNames[i]) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Print polls or waits per 100 bytes. The RX count also depends on how often
+// the shell polls: lower means each poll found a bigger batch.
+static void printPollRate(const char *label, const char *what, unsigned long count, unsigned long bytes) {
+  unsigned long per100 = bytes ? (count * 100) / bytes : 0;
+  printf("%s %d bytes, %d %s, %d per 100 bytes\n", label, (int)bytes, (int)count, what, (int)per100);
+}
+
+void setFifoLevels(int argc, char **argv) {
+  char *rxStr = argc > 1 ? argv[1] : NULL;
+  char *txStr = argc > 2 ? argv[2] : NULL;
+  unsigned int rxLevel, txLevel;
+
+  if (rxStr) {
+    int rx = parseFifoLevel(rxStr);
+    int tx = txStr ? parseFifoLevel(txStr) : rx;
+
+    if (rx < 0 || tx < 0 || !uart0_set_fifo_levels(rx, tx)) {
+      printf("\nInvalid FIFO level. Use 1/8, 1/4, 1/2, 3/4 or 7/8.\n");
+      return;
+    }
+    uart_reset_stats(UART_PORT_PL011);
+  }
+
+  uart0_get_fifo_levels(&rxLevel, &txLevel);
+  printf("\nRX level %s, TX level %s\n", fifoLevelNames[rxLevel], fifoLevelNames[txLevel]);
+  printPollRate("RX:", "polls with data ready", uart0_stats.rx_polls, uart0_stats.rx_bytes);
+  printPollRate("TX:", "waits for FIFO space", uart0_stats.tx_waits, uart0_stats.tx_bytes);
+}
+
+void showUartStats(int argc, char **argv) {
+  if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+    for (int i = 0; i < UART_PORT_COUNT; i++) {
+      uart_reset_stats(i);
+    }
+    printf("\nUART counters reset.\n");
+    return;
   }
-}
\ No newline at end of file
+
+  for (int i = 0; i < UART_PORT_COUNT; i++) {
+    UartStats *stats = uartPorts[i]->stats;
+
+    PRINTF_FMT(UART_PORT, i, uartPorts[i]->name);
+    PRINTF_FMT(UART_COUNTER, "bytes in", stats->rx_bytes);
+    PRINTF_FMT(UART_COUNTER, "bytes out", stats->tx_bytes);
+    PRINTF_FMT(UART_COUNTER, "overruns", stats->overruns);
+    PRINTF_FMT(UART_COUNTER, "framing errors", stats->framing_errors);
+    PRINTF_FMT(UART_COUNTER, "parity errors", stats->parity_errors);
+    PRINTF_FMT(UART_COUNTER, "break errors", stats->break_errors);
+    PRINTF_FMT(UART_COUNTER, "TX stall us", timer_ticks_to_us(stats->tx_stall_ticks));
+    PRINTF_FMT(UART_COUNTER, "peak RX ring", stats->rx_peak);
+    PRINTF_FMT(UART_COUNTER, "host throttled", stats->throttles);
+    PRINTF_FMT(UART_COUNTER, "XOFF received", stats->remote_pauses);
+  }
+}
+
+void showDlog(int argc, char **argv) {
+  if (argc > 1 && strcmp(argv[1], "flush") == 0 && dlog_flush() < 0) {
+    printf("\nThe log port is the console, pick another with set_port log <port> to flush.\n");
+  }
+
+  printf("\nRecords %9c %lu\n", ':', dlogStats.records);
+  printf("Encoded bytes %3c %lu\n", ':', dlogStats.bytes);
+  printf("Dropped %9c %lu\n", ':', dlogStats.dropped);
+  printf("Queued bytes %4c %lu\n", ':', (unsigned long)dlog_pending());
+}
+void setLogMask(int argc, char **argv) {
+  char *module = argc > 1 ? argv[1] : NULL;
+  char *state = argc > 2 ? argv[2] : NULL;
+
+  if (module) {
+    uint32_t bits = 0;
+
+    if (strcmp(module, "all") == 0) {
+      bits = (1u << LOG_MOD_COUNT) - 1;
+    } else {
+      for (int i = 0; i < LOG_MOD_COUNT; i++) {
+        if (strcmp(module, logModuleNames[i]) == 0)
+          bits = 1u << i;
+      }
+    }
+
+    if (!bits || !state || (strcmp(state, "on") != 0 && strcmp(state, "off") != 0)) {
+      printf("\nUsage: logmask [<module>|all on|off]\n");
+      return;
+    }
+
+    if (strcmp(state, "on") == 0)
+      logMask |= bits;
+    else
+      logMask &= ~bits;
+  }
+
+  printf("\n");
+  for (int i = 0; i < LOG_MOD_COUNT; i++) {
+    printf("%8s : %s\n", logModuleNames[i], (logMask & (1u << i)) ? "on" : "off");
+  }
+}
+
+static const char *consolePolicyNames[] = {"none", "line", "full"};
+
+void showConsole(int argc, char **argv) {
+  char *name = argc > 1 ? argv[1] : NULL;
+  char *setting = argc > 2 ? argv[2] : NULL;
+
+  if (name) {
+    ConsoleSink *sink = console_find(name);
+    int policy = -1;
+
+    for (int i = 0; setting && i < 3; i++) {
+      if (strcmp(setting, consolePolicyNames[i]) == 0)
+        policy = i;
+    }
+
+    if (!sink || !setting) {
+      printf("\nUsage: console [<sink> line|full|none|on|off]\n");
+      return;
+    }
+
+    if (policy >= 0)
+      console_set_policy(sink, policy);
+    else if (strcmp(setting, "on") == 0 || strcmp(setting, "off") == 0)
+      console_enable(sink, strcmp(setting, "on") == 0);
+    else {
+      printf("\nInvalid setting: %s\n", setting);
+      return;
+    }
+  }
+
+  printf("\nSink      Buffer  State  Bytes       Flushes\n");
+  for (int i = 0; i < console_sink_count(); i++) {
+    ConsoleSink *sink = console_sink(i);
+    printf("%8s  %6s  %5s  %10lu  %lu\n", sink->name, consolePolicyNames[sink->policy],
+           sink->enabled ? "on" : "off", sink->bytes, sink->flushes);
+  }
+  printf("Lines dropped by full lanes: %lu\n", console_lines_dropped());
+}
+
+void showDmesg(int argc, char **argv) {
+  static char logCopy[PLOG_SIZE + 1];
+  char *filter = NULL;
+  int clear = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-c") == 0)
+      clear = 1;
+    else
+      filter = argv[i];
+  }
+
+  // snapshot first, printing appends to the log
+  size_t len = plog_read(logCopy, sizeof(logCopy));
+  char *line = logCopy;
+
+  // a full ring starts part way through a line
+  if (len == PLOG_SIZE) {
+    char *first = strchr(line, '\n');
+    line = first ? first + 1 : line + len;
+  }
+
+  printf("\n");
+  if (filter) {
+    // search the whole snapshot, then widen each hit to its line
+    size_t filterLen = strlen(filter);
+    char *end = logCopy + len;
+
+    while (line < end) {
+      char *hit = memmem(line, end - line, filter, filterLen);
+      if (!hit)
+        break;
+
+      char *start = hit;
+      while (start > line && start[-1] != '\n')
+        start--;
+      char *stop = memchr(hit, '\n', end - hit);
+      if (!stop)
+        stop = end;
+
+      *stop = '\0';
+      printf("%s\n", start);
+      line = stop + 1;
+    }
+  }
+  else {
+    while (*line) {
+      char *end = strchr(line, '\n');
+      if (end)
+        *end = '\0';
+      printf("%s\n", line);
+      if (!end)
+        break;
+      line = end + 1;
+    }
+  }
+
+  if (clear)
+    plog_clear();
+}
+
+// Decimal or 0x hex, with an optional K or M multiplier
+static int parseSize(const char *str, unsigned long *value) {
+  char *end;
+  int hex = str[0] == '0' && (str[1] == 'x' || str[1] == 'X');
+
+  *value = strtoul(hex ? str + 2 : str, &end, hex ? 16 : 10);
+  if (end == str || (hex && end == str + 2))
+    return 0;
+  if (*end == 'K' || *end == 'k') {
+    *value <<= 10;
+    end++;
+  }
+  else if (*end == 'M' || *end == 'm') {
+    *value <<= 20;
+    end++;
+  }
+  return *end == '\0';
+}
+
+// Megabytes per second for len bytes in ticks of the system counter
+static double throughput(unsigned long len, unsigned long ticks) {
+  return (double)len * timer_freq() / (ticks ? ticks : 1) / 1000000.0;
+}
+
+void checksumMemory(int argc, char **argv) {
+  unsigned long addr, len;
+
+  if (argc < 3 || !parseSize(argv[1], &addr) || !parseSize(argv[2], &len) || !len) {
+    printf("\nUsage: crc32 <addr> <len>\n");
+    return;
+  }
+  // reading a peripheral register can pop a FIFO, stay in RAM
+  if (addr >= MMIO_BASE || len > MMIO_BASE - addr) {
+    printf("\nThe range must end below the peripherals at 0x%x\n", MMIO_BASE);
+    return;
+  }
+
+  const void *data = (const void *)addr;
+  unsigned long start = timer_ticks();
+  uint32_t ieee = crc32(0, data, len);
+  unsigned long ieeeTicks = timer_ticks() - start;
+
+  start = timer_ticks();
+  uint32_t castagnoli = crc32c(0, data, len);
+  unsigned long castagnoliTicks = timer_ticks() - start;
+
+  start = timer_ticks();
+  crc32_table(0, data, len);
+  unsigned long tableTicks = timer_ticks() - start;
+
+  printf("\nCRC-32 %9c %08x  %.1f MB/s\n", ':', ieee, throughput(len, ieeeTicks));
+  printf("CRC-32C %8c %08x  %.1f MB/s\n", ':', castagnoli, throughput(len, castagnoliTicks));
+  printf("CRC-32 table %3c %.1f MB/s\n", ':', throughput(len, tableTicks));
+  printf("Method %9c %s\n", ':', crc32_hw() ? "crc32x, 3 interleaved streams" : "slicing-by-8 table");
+}
+
+void showPages(int argc, char **argv) {
+  PageStats stats;
+  page_alloc_stats(&stats);
+
+  printf("Managed 0x%lx - 0x%lx: %lu pages, %lu free (%lu KB)\n", (unsigned long)stats.start,
+         (unsigned long)stats.end, stats.totalPages, stats.freePages, stats.freePages * (PAGE_SIZE / 1024));
+  printf("%lu allocations, %lu failed\n\n", stats.allocs, stats.failures);
+  printf("order    size   free blocks\n");
+  for (unsigned int order = 0; order < PAGE_ORDERS; order++) {
+    unsigned long kb = (PAGE_SIZE << order) / 1024;
+    printf("%5u  %4lu%s   %lu\n", order, kb >= 1024 ? kb / 1024 : kb, kb >= 1024 ? "MB" : "KB",
+           stats.freeBlocks[order]);
+  }
+}
+
+void showMemInfo(int argc, char **argv) {
+  static unsigned long lastTicks, lastAllocs, lastFrees;
+  PageStats pages;
+  SlabStats slabs;
+
+  page_alloc_stats(&pages);
+  slab_stats(&slabs);
+
+  // free memory not in 2MB blocks can't serve the largest requests
+  unsigned long whole = pages.freeBlocks[PAGE_MAX_ORDER] << PAGE_MAX_ORDER;
+  printf("Pages: %lu total, %lu free (%lu KB), %lu%% of the free pages in 2MB blocks\n",
+         pages.totalPages, pages.freePages, pages.freePages * (PAGE_SIZE / 1024),
+         pages.freePages ? whole * 100 / pages.freePages : 0);
+
+  unsigned long allocs = slabs.largeAllocs, frees = slabs.largeFrees, slabBytes = 0, usedBytes = 0;
+  printf("\n class  slabs  objects  in use  cached  used    allocs     frees\n");
+  for (unsigned int i = 0; i < SLAB_CLASSES; i++) {
+    SlabClassStats *c = &slabs.classes[i];
+    unsigned long inuse = c->objects - c->free - c->cached;
+
+    printf("%6lu%7lu%9lu%8lu%8lu%5lu%%%10lu%10lu\n", c->size, c->slabs, c->objects, inuse, c->cached,
+           c->objects ? inuse * 100 / c->objects : 0, c->allocs, c->frees);
+    allocs += c->allocs;
+    frees += c->frees;
+    slabBytes += c->slabs * (PAGE_SIZE << SLAB_ORDER);
+    usedBytes += inuse * c->size;
+  }
+  printf("Large: %lu blocks, %lu pages\n", slabs.largeBlocks, slabs.largePages);
+  printf("Slab memory: %lu KB, %lu%% in live objects\n", slabBytes / 1024, slabBytes ? usedBytes * 100 / slabBytes : 0);
+
+  unsigned long now = timer_ticks();
+  if (lastTicks) {
+    double seconds = (double)(now - lastTicks) / timer_freq();
+    printf("kmalloc: %lu allocs, %lu frees, %lu failed, %.1f allocs/s and %.1f frees/s over the last %.1fs\n",
+           allocs, frees, slabs.failures, (allocs - lastAllocs) / seconds, (frees - lastFrees) / seconds, seconds);
+  }
+  else {
+    printf("kmalloc: %lu allocs, %lu frees, %lu failed, run meminfo again for rates\n", allocs, frees, slabs.failures);
+  }
+  lastTicks = now;
+  lastAllocs = allocs;
+  lastFrees = frees;
+}
@@ -1,11 +1,11 @@
 #ifndef COMMAND_H
 #define COMMAND_H
 
-#define COMMAND_COUNT 10
+#define COMMAND_COUNT 27
 #define COLOR_COUNT 8
 
 // Function type for command handlers
-typedef void (*CommandFunction)(char *args);
+typedef void (*CommandFunction)(int argc, char **argv);
 
 // Struct to represent a command
 typedef struct{
@@ -25,18 +25,30 @@ extern Command commandList[COMMAND_COUNT];
 extern ColorMap colorMappings[COLOR_COUNT];
 
 // Declarations
+Command *findCommand(const char *name);  // NULL if there is no such command
 const char *findTextColor(const char *colorStr);
 const char *findAsciiBgColor(const char *colorStr);
-void displayAllCommands(char *args);
-void clearScreen(char *args);
-void setConsoleColor(char *args);
-void displayBoardInfo(char *args);
+void displayAllCommands(int argc, char **argv);
+void clearScreen(int argc, char **argv);
+void setConsoleColor(int argc, char **argv);
+void displayBoardInfo(int argc, char **argv);
 
 // uart commands
-void setBaudRate(char *args);
-void setDataBits(char *args);
-void setStopBits(char *args);
-void setParity(char *args);
-void setHandshaking(char *args);
+void setBaudRate(int argc, char **argv);
+void setDataBits(int argc, char **argv);
+void setStopBits(int argc, char **argv);
+void setParity(int argc, char **argv);
+void setHandshaking(int argc, char **argv);
+void switchBaudRate(int argc, char **argv);
+void selectPort(int argc, char **argv);
+void setFifoLevels(int argc, char **argv);
+void showUartStats(int argc, char **argv);
+void showDlog(int argc, char **argv);
+void setLogMask(int argc, char **argv);
+void showConsole(int argc, char **argv);
+void showDmesg(int argc, char **argv);
+void checksumMemory(int argc, char **argv);
+void showPages(int argc, char **argv);
+void showMemInfo(int argc, char **argv);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,129 @@
+#ifndef FMTPARSE_H
+#define FMTPARSE_H
+
+#include "../gcclib/stdint.h"
+
+/*
+ * Format string parsing shared by the runtime formatter (cli/printf.c) and the
+ * build-time generator (tools/fmtgen.c), so both read a format the same way.
+ */
+
+// Length modifiers
+#define FMT_LEN_INT   0
+#define FMT_LEN_LONG  1   // l, ll, z (all 64-bit on AArch64)
+
+// One conversion and the literal text in front of it
+typedef struct {
+  uint16_t literal;    // literal bytes before the conversion
+  uint8_t skip;        // bytes of the conversion itself, '%' included
+  char conv;           // conversion character, 0 for a trailing literal
+  uint8_t zeroPad;
+  uint8_t length;      // FMT_LEN_*
+  int16_t width;
+  int16_t precision;   // -1 when not given
+} FmtSpec;
+
+// A format string parsed ahead of time
+typedef struct {
+  const char *text;
+  const FmtSpec *specs;
+  uint16_t count;
+} FmtProgram;
+
+/**
+ * Parse the conversion starting at the '%' in s, returns the byte after it.
+ * A '%' ending the string gives conv 0.
+ */
+static inline const char *fmt_parse_spec(const char *s, FmtSpec *spec) {
+  const char *start = s++;
+
+  spec->zeroPad = 0;
+  spec->width = 0;
+  spec->precision = -1;
+  spec->length = FMT_LEN_INT;
+
+  if (*s == '0') {
+    spec->zeroPad = 1;
+    s++;
+  }
+
+  while (*s >= '0' && *s <= '9') {
+    spec->width = spec->width * 10 + (*s - '0');
+    s++;
+  }
+
+  if (*s == '.') {
+    spec->precision = 0;
+    s++;
+    while (*s >= '0' && *s <= '9') {
+      spec->precision = spec->precision * 10 + (*s - '0');
+      s++;
+    }
+  }
+
+  while (*s == 'l' || *s == 'z') {
+    spec->length = FMT_LEN_LONG;
+    s++;
+  }
+
+  spec->conv = *s;
+  if (*s) {
+    s++;
+  }
+  spec->skip = (uint8_t)(s - start);
+  return s;
+}
+
+/**
+ * 1 if the conversion consumes an argument
+ */
+static inline int fmt_takes_arg(char conv) {
+  switch (conv) {
+  case 'd': case 'i': case 'c':
+  case 'u': case 'x': case 'X': case 'o': case 'b': case 'p':
+  case 's':
+  case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+/**
+ * Split a whole format string into specs, returns how many were written
+ * (at most max) or -1 if they don't fit
+ */
+static inline int fmt_compile(const char *text, FmtSpec *specs, int max) {
+  int count = 0;
+
+  while (*text) {
+    const char *literal = text;
+    while (*text && *text != '%') {
+      text++;
+    }
+    if (count == max) {
+      return -1;
+    }
+
+    FmtSpec *spec = &specs[count++];
+    uint16_t literalLen = (uint16_t)(text - literal);
+    if (*text) {
+      text = fmt_parse_spec(text, spec);
+      if (!spec->conv) {
+        spec->conv = '%';  // a lone '%' at the end prints as itself
+      }
+    }
+    else {
+      spec->conv = 0;
+      spec->skip = 0;
+      spec->zeroPad = 0;
+      spec->length = FMT_LEN_INT;
+      spec->width = 0;
+      spec->precision = -1;
+    }
+    spec->literal = literalLen;
+  }
+  return count;
+}
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef FORMATS_H
+#define FORMATS_H
+
+/*
+ * Format strings parsed at build time
+ * tools/fmtgen turns each entry of FORMAT_LIST into a FmtProgram
+ * (fmtProgram_<ID> in build/fmt_gen.c), so printing it skips the flag, width
+ * and precision parsing. Use PRINTF_FMT(ID, ...) or SNPRINTF_FMT(buf, size, ID, ...).
+ * To add a format, define FMT_<ID> and list ID below.
+ */
+
+#define FMT_LOG_PREFIX    "[%s %s] "
+#define FMT_UART_PORT     "\nPort %d: %s\n"
+#define FMT_UART_COUNTER  "  %15s: %lu\n"
+#define FMT_BENCH_LINE    "%08lx %5d %s %lu\n"
+
+#define FORMAT_LIST(X) \
+  X(LOG_PREFIX) \
+  X(UART_PORT) \
+  X(UART_COUNTER) \
+  X(BENCH_LINE)
+
+#define FMT_DECLARE(id) extern const FmtProgram fmtProgram_##id;
+FORMAT_LIST(FMT_DECLARE)
+
+#endif
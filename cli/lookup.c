@@ -0,0 +1,56 @@
+#include "command.h"
+#include "../kernel/string.h"
+#include "../kernel/hash.h"
+#include "../kernel/containers.h"
+
+// Name lookup for commandList and colorMappings. Kept apart from the
+// handlers in command.c so the host tests (test/test_cli.c) can link it
+// against their own tables.
+
+#define NAME_EQUAL(a, b) (strcmp(a, b) == 0)
+HASHMAP_DEFINE(NameMap, const char *, unsigned int, hash_str, NAME_EQUAL)
+
+// commandList and colorMappings by name (index into the array), filled on the first lookup
+#define COMMAND_MAP_SIZE 64  // power of two, above COMMAND_COUNT * 8 / 7
+#define COLOR_MAP_SIZE 16
+static NameMap commandMap, colorMap;
+static NameMap_slot commandSlots[COMMAND_MAP_SIZE], colorSlots[COLOR_MAP_SIZE];
+static uint32_t commandTags[COMMAND_MAP_SIZE], colorTags[COLOR_MAP_SIZE];
+static int mapsBuilt = 0;
+
+static void buildMaps(void) {
+  NameMap_init(&commandMap, commandSlots, commandTags, COMMAND_MAP_SIZE);
+  for (unsigned int i = 0; i < COMMAND_COUNT; i++)
+    NameMap_put(&commandMap, commandList[i].name, i);
+
+  NameMap_init(&colorMap, colorSlots, colorTags, COLOR_MAP_SIZE);
+  for (unsigned int i = 0; i < COLOR_COUNT; i++)
+    NameMap_put(&colorMap, colorMappings[i].colorName, i);
+  mapsBuilt = 1;
+}
+
+Command *findCommand(const char *name) {
+  if (!mapsBuilt)
+    buildMaps();
+
+  unsigned int *index = NameMap_find(&commandMap, name);
+  return index ? &commandList[*index] : NULL;
+}
+
+static const ColorMap *findColor(const char *colorStr) {
+  if (!mapsBuilt)
+    buildMaps();
+
+  unsigned int *index = NameMap_find(&colorMap, colorStr);
+  return index ? &colorMappings[*index] : NULL; // NULL if not found
+}
+
+const char *findTextColor(const char *colorStr){
+  const ColorMap *color = findColor(colorStr);
+  return color ? color->textColorAscii : NULL;
+}
+
+const char *findAsciiBgColor(const char *colorStr){
+  const ColorMap *color = findColor(colorStr);
+  return color ? color->bgColorAscii : NULL;
+}
@@ -1,113 +1,1049 @@
 #include "./printf.h"
-#include "../uart/uart1.h"
+#include "../kernel/console.h"
 
-#define MAX_PRINT_SIZE 256
+// Size of the staging buffer handed to the sink in one go
+#define PRINT_CHUNK_SIZE 64
+
+// Output state of one formatting call
+typedef struct {
+  PrintSink sink;
+  void *ctx;
+  char chunk[PRINT_CHUNK_SIZE];
+  size_t len;
+  int total;
+} PrintOut;
+
+// Hand the staged characters to the sink
+static void out_flush(PrintOut *out) {
+  if (out->len) {
+    out->sink(out->ctx, out->chunk, out->len);
+    out->len = 0;
+  }
+}
+
+static void out_char(PrintOut *out, char c) {
+  if (out->len == PRINT_CHUNK_SIZE) {
+    out_flush(out);
+  }
+  out->chunk[out->len++] = c;
+  out->total++;
+}
+
+static void out_str(PrintOut *out, const char *s, size_t len) {
+  while (len--) {
+    out_char(out, *s++);
+  }
+}
 
 // Helper function for padding
-void add_padding(char *buffer, int *buffer_index, int pad_count, int width, int zeroPad) {
+static void add_padding(PrintOut *out, int pad_count, int width, int zeroPad) {
   char pad_char = zeroPad ? '0' : ' ';
-  while(pad_count < width && *buffer_index < MAX_PRINT_SIZE - 1){
-    buffer[(*buffer_index)++] = pad_char;
+  while (pad_count < width) {
+    out_char(out, pad_char);
     pad_count++;
   }
 }
 
-// Helper function for integer to ASCII conversion
-void itoa(int num, char *temp_buffer, int *temp_index, int base) {
-  int is_negative = 0;
-  if (num < 0 && base == 10) {  // Handle negative numbers only for decimal
-    is_negative = 1;
-    num = -num;
+// "00" .. "99", two digits per division
+static const char digitPairs[201] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+static const char lowerDigits[] = "0123456789abcdef";
+static const char upperDigits[] = "0123456789ABCDEF";
+
+// Decimal conversion written backwards from end, returns the first digit
+char *utoa_dec(uint64_t num, char *end) {
+  while (num >= 100) {
+    unsigned int pair = (unsigned int)(num % 100) * 2;
+    num /= 100;
+    *--end = digitPairs[pair + 1];
+    *--end = digitPairs[pair];
   }
 
-  while ((num /= base) != 0){
-    int digit = num % base;
-    temp_buffer[(*temp_index)--] = digit < 10 ? '0' + digit : 'a' + (digit - 10);
+  if (num >= 10) {
+    unsigned int pair = (unsigned int)num * 2;
+    *--end = digitPairs[pair + 1];
+    *--end = digitPairs[pair];
+  }
+  else {
+    *--end = '0' + (char)num;
   }
+  return end;
+}
+
+// Power of two bases (binary, octal, hex) only need shifts and masks
+char *utoa_pow2(uint64_t num, char *end, int shift, const char *digits) {
+  uint64_t mask = (1u << shift) - 1;
+  do {
+    *--end = digits[num & mask];
+    num >>= shift;
+  } while (num);
+  return end;
+}
+
+/*
+ * Grisu2 (Loitsch, "Printing Floating-Point Numbers Quickly and Accurately
+ * with Integers"). The double is scaled by a cached power of ten so its digits
+ * come out of 64-bit integer arithmetic, with no bignums. The result is the
+ * shortest (or very nearly shortest) digit string that reads back as the same
+ * double.
+ */
 
-  if (is_negative) {
-    temp_buffer[(*temp_index)--] = '-';
+// Floating point value f * 2^e with a 64-bit significand
+typedef struct {
+  uint64_t f;
+  int e;
+} DiyFp;
+
+#define DP_SIGNIFICAND_MASK 0x000FFFFFFFFFFFFFULL
+#define DP_HIDDEN_BIT       0x0010000000000000ULL
+#define DP_EXPONENT_BIAS    (0x3FF + 52)
+
+// Normalized 10^k for k = -348, -340, ..., 340
+static const DiyFp cachedPowers[] = {
+  {0xfa8fd5a0081c0288ULL, -1220},  // 1e-348
+  {0xbaaee17fa23ebf76ULL, -1193},  // 1e-340
+  {0x8b16fb203055ac76ULL, -1166},  // 1e-332
+  {0xcf42894a5dce35eaULL, -1140},  // 1e-324
+  {0x9a6bb0aa55653b2dULL, -1113},  // 1e-316
+  {0xe61acf033d1a45dfULL, -1087},  // 1e-308
+  {0xab70fe17c79ac6caULL, -1060},  // 1e-300
+  {0xff77b1fcbebcdc4fULL, -1034},  // 1e-292
+  {0xbe5691ef416bd60cULL, -1007},  // 1e-284
+  {0x8dd01fad907ffc3cULL, -980},  // 1e-276
+  {0xd3515c2831559a83ULL, -954},  // 1e-268
+  {0x9d71ac8fada6c9b5ULL, -927},  // 1e-260
+  {0xea9c227723ee8bcbULL, -901},  // 1e-252
+  {0xaecc49914078536dULL, -874},  // 1e-244
+  {0x823c12795db6ce57ULL, -847},  // 1e-236
+  {0xc21094364dfb5637ULL, -821},  // 1e-228
+  {0x9096ea6f3848984fULL, -794},  // 1e-220
+  {0xd77485cb25823ac7ULL, -768},  // 1e-212
+  {0xa086cfcd97bf97f4ULL, -741},  // 1e-204
+  {0xef340a98172aace5ULL, -715},  // 1e-196
+  {0xb23867fb2a35b28eULL, -688},  // 1e-188
+  {0x84c8d4dfd2c63f3bULL, -661},  // 1e-180
+  {0xc5dd44271ad3cdbaULL, -635},  // 1e-172
+  {0x936b9fcebb25c996ULL, -608},  // 1e-164
+  {0xdbac6c247d62a584ULL, -582},  // 1e-156
+  {0xa3ab66580d5fdaf6ULL, -555},  // 1e-148
+  {0xf3e2f893dec3f126ULL, -529},  // 1e-140
+  {0xb5b5ada8aaff80b8ULL, -502},  // 1e-132
+  {0x87625f056c7c4a8bULL, -475},  // 1e-124
+  {0xc9bcff6034c13053ULL, -449},  // 1e-116
+  {0x964e858c91ba2655ULL, -422},  // 1e-108
+  {0xdff9772470297ebdULL, -396},  // 1e-100
+  {0xa6dfbd9fb8e5b88fULL, -369},  // 1e-92
+  {0xf8a95fcf88747d94ULL, -343},  // 1e-84
+  {0xb94470938fa89bcfULL, -316},  // 1e-76
+  {0x8a08f0f8bf0f156bULL, -289},  // 1e-68
+  {0xcdb02555653131b6ULL, -263},  // 1e-60
+  {0x993fe2c6d07b7facULL, -236},  // 1e-52
+  {0xe45c10c42a2b3b06ULL, -210},  // 1e-44
+  {0xaa242499697392d3ULL, -183},  // 1e-36
+  {0xfd87b5f28300ca0eULL, -157},  // 1e-28
+  {0xbce5086492111aebULL, -130},  // 1e-20
+  {0x8cbccc096f5088ccULL, -103},  // 1e-12
+  {0xd1b71758e219652cULL, -77},  // 1e-4
+  {0x9c40000000000000ULL, -50},  // 1e4
+  {0xe8d4a51000000000ULL, -24},  // 1e12
+  {0xad78ebc5ac620000ULL, 3},  // 1e20
+  {0x813f3978f8940984ULL, 30},  // 1e28
+  {0xc097ce7bc90715b3ULL, 56},  // 1e36
+  {0x8f7e32ce7bea5c70ULL, 83},  // 1e44
+  {0xd5d238a4abe98068ULL, 109},  // 1e52
+  {0x9f4f2726179a2245ULL, 136},  // 1e60
+  {0xed63a231d4c4fb27ULL, 162},  // 1e68
+  {0xb0de65388cc8ada8ULL, 189},  // 1e76
+  {0x83c7088e1aab65dbULL, 216},  // 1e84
+  {0xc45d1df942711d9aULL, 242},  // 1e92
+  {0x924d692ca61be758ULL, 269},  // 1e100
+  {0xda01ee641a708deaULL, 295},  // 1e108
+  {0xa26da3999aef774aULL, 322},  // 1e116
+  {0xf209787bb47d6b85ULL, 348},  // 1e124
+  {0xb454e4a179dd1877ULL, 375},  // 1e132
+  {0x865b86925b9bc5c2ULL, 402},  // 1e140
+  {0xc83553c5c8965d3dULL, 428},  // 1e148
+  {0x952ab45cfa97a0b3ULL, 455},  // 1e156
+  {0xde469fbd99a05fe3ULL, 481},  // 1e164
+  {0xa59bc234db398c25ULL, 508},  // 1e172
+  {0xf6c69a72a3989f5cULL, 534},  // 1e180
+  {0xb7dcbf5354e9beceULL, 561},  // 1e188
+  {0x88fcf317f22241e2ULL, 588},  // 1e196
+  {0xcc20ce9bd35c78a5ULL, 614},  // 1e204
+  {0x98165af37b2153dfULL, 641},  // 1e212
+  {0xe2a0b5dc971f303aULL, 667},  // 1e220
+  {0xa8d9d1535ce3b396ULL, 694},  // 1e228
+  {0xfb9b7cd9a4a7443cULL, 720},  // 1e236
+  {0xbb764c4ca7a44410ULL, 747},  // 1e244
+  {0x8bab8eefb6409c1aULL, 774},  // 1e252
+  {0xd01fef10a657842cULL, 800},  // 1e260
+  {0x9b10a4e5e9913129ULL, 827},  // 1e268
+  {0xe7109bfba19c0c9dULL, 853},  // 1e276
+  {0xac2820d9623bf429ULL, 880},  // 1e284
+  {0x80444b5e7aa7cf85ULL, 907},  // 1e292
+  {0xbf21e44003acdd2dULL, 933},  // 1e300
+  {0x8e679c2f5e44ff8fULL, 960},  // 1e308
+  {0xd433179d9c8cb841ULL, 986},  // 1e316
+  {0x9e19db92b4e31ba9ULL, 1013},  // 1e324
+  {0xeb96bf6ebadf77d9ULL, 1039},  // 1e332
+  {0xaf87023b9bf0ee6bULL, 1066},  // 1e340
+};
+
+static const uint64_t pow10Table[] = {
+  1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+  100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+  10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+  100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+static DiyFp diy_mul(DiyFp a, DiyFp b) {
+  unsigned __int128 p = (unsigned __int128)a.f * b.f;
+  uint64_t hi = (uint64_t)(p >> 64);
+  hi += ((uint64_t)p >> 63) & 1;  // round the dropped half
+  DiyFp r = {hi, a.e + b.e + 64};
+  return r;
+}
+
+static DiyFp diy_normalize(DiyFp v) {
+  int shift = __builtin_clzll(v.f);
+  v.f <<= shift;
+  v.e -= shift;
+  return v;
+}
+
+// Cached power c = 10^-K such that the product with 2^e lands in [2^-60, 2^-32]
+static DiyFp cached_power(int e, int *K) {
+  double dk = (-61 - e) * 0.30102999566398114 + 347;
+  int k = (int)dk;
+  if (dk - k > 0.0) {
+    k++;
   }
+  unsigned int index = (unsigned int)((k >> 3) + 1);
+  *K = -(-348 + (int)index * 8);
+  return cachedPowers[index];
 }
 
-// Main printf function
-void printf(const char *string, ...) {
-  va_list ap;
-  va_start(ap, string);
-  
-  char buffer[MAX_PRINT_SIZE];
-  int buffer_index = 0;
+// Move the last digit towards w while it stays inside the rounding interval
+static void grisu_round(char *buffer, int len, uint64_t delta, uint64_t rest,
+                        uint64_t tenKappa, uint64_t wpW) {
+  while (rest < wpW && delta - rest >= tenKappa &&
+         (rest + tenKappa < wpW || wpW - rest > rest + tenKappa - wpW)) {
+    buffer[len - 1]--;
+    rest += tenKappa;
+  }
+}
 
-  while (*string && buffer_index < MAX_PRINT_SIZE - 1) {
-    if (*string != '%') {
-      buffer[buffer_index++] = *string++;
+static int count_digits32(uint32_t n) {
+  int count = 1;
+  while (count < 10 && n >= pow10Table[count]) {
+    count++;
+  }
+  return count;
+}
+
+static int digit_gen(DiyFp w, DiyFp mp, uint64_t delta, char *buffer, int *K) {
+  DiyFp one = {1ULL << -mp.e, mp.e};
+  uint64_t wpW = mp.f - w.f;
+  uint32_t p1 = (uint32_t)(mp.f >> -one.e);
+  uint64_t p2 = mp.f & (one.f - 1);
+  int kappa = count_digits32(p1);
+  int len = 0;
+
+  // integral part, one division per digit on a 32-bit value
+  while (kappa > 0) {
+    uint32_t divisor = (uint32_t)pow10Table[kappa - 1];
+    uint32_t d = p1 / divisor;
+    p1 %= divisor;
+    if (d || len) {
+      buffer[len++] = '0' + (char)d;
+    }
+    kappa--;
+
+    uint64_t rest = ((uint64_t)p1 << -one.e) + p2;
+    if (rest <= delta) {
+      *K += kappa;
+      grisu_round(buffer, len, delta, rest, pow10Table[kappa] << -one.e, wpW);
+      return len;
+    }
+  }
+
+  // fractional part, multiply by ten instead of dividing
+  for (;;) {
+    p2 *= 10;
+    delta *= 10;
+    char d = (char)(p2 >> -one.e);
+    if (d || len) {
+      buffer[len++] = '0' + d;
+    }
+    p2 &= one.f - 1;
+    kappa--;
+
+    if (p2 < delta) {
+      *K += kappa;
+      grisu_round(buffer, len, delta, p2, one.f, -kappa < 20 ? wpW * pow10Table[-kappa] : 0);
+      return len;
+    }
+  }
+}
+
+/**
+ * Shortest digits of a finite, positive double: value = digits * 10^exp10.
+ * Writes at most DTOA_DIGITS_MAX digits (not NUL terminated), returns the count.
+ */
+int dtoa_shortest(double value, char *digits, int *exp10) {
+  union { double d; uint64_t u; } bits = {value};
+  int biased = (int)((bits.u >> 52) & 0x7FF);
+  uint64_t significand = bits.u & DP_SIGNIFICAND_MASK;
+  DiyFp v;
+
+  if (value == 0.0) {
+    digits[0] = '0';
+    *exp10 = 0;
+    return 1;
+  }
+
+  if (biased) {
+    v.f = significand + DP_HIDDEN_BIT;
+    v.e = biased - DP_EXPONENT_BIAS;
+  }
+  else {
+    v.f = significand;
+    v.e = 1 - DP_EXPONENT_BIAS;
+  }
+
+  // boundaries halfway to the neighbouring doubles, sharing the upper one's exponent
+  DiyFp plus = {(v.f << 1) + 1, v.e - 1};
+  plus = diy_normalize(plus);
+  DiyFp minus;
+  if (v.f == DP_HIDDEN_BIT) {
+    minus.f = (v.f << 2) - 1;
+    minus.e = v.e - 2;
+  }
+  else {
+    minus.f = (v.f << 1) - 1;
+    minus.e = v.e - 1;
+  }
+  minus.f <<= minus.e - plus.e;
+  minus.e = plus.e;
+
+  int K;
+  DiyFp c = cached_power(plus.e, &K);
+  DiyFp w = diy_mul(diy_normalize(v), c);
+  DiyFp wp = diy_mul(plus, c);
+  DiyFp wm = diy_mul(minus, c);
+  wm.f++;
+  wp.f--;
+
+  *exp10 = K;
+  return digit_gen(w, wp, wp.f - wm.f, digits, exp10);
+}
+
+/*
+ * Exact digits, for a precision the shortest digits can't serve. Rounding
+ * those again would round twice: 0.15 is 0.1499999999999999944..., its
+ * shortest digits "15" round up to 0.2 at one decimal. The value m * 2^e is
+ * expanded exactly instead, the integer part by dividing a bignum by 10^9,
+ * the fraction by multiplying a bignum by 10^9 and taking the carry out of
+ * its top.
+ */
+
+// 32-bit limbs for 53 significant bits shifted by up to 1074
+#define EXACT_LIMBS 36
+// A double's exact expansion has at most 767 significant digits, plus the rest of a 9 digit chunk
+#define DTOA_EXACT_MAX 776
+// Up to this many digits, shortest digits that fit the precision are also the correctly rounded ones
+#define DTOA_FAST_DIGITS 15
+
+// Divide the bignum (limbs[0] least significant) by 10^9, returns the remainder
+static uint32_t big_div_1e9(uint32_t *limbs, int *len) {
+  uint64_t rem = 0;
+  for (int i = *len - 1; i >= 0; i--) {
+    uint64_t cur = (rem << 32) | limbs[i];
+    limbs[i] = (uint32_t)(cur / 1000000000u);
+    rem = cur % 1000000000u;
+  }
+  while (*len && !limbs[*len - 1]) {
+    (*len)--;
+  }
+  return (uint32_t)rem;
+}
+
+// Multiply the fraction (limbs[0] most significant) by 10^9, returns the integer part
+static uint32_t frac_mul_1e9(uint32_t *limbs, int *len) {
+  uint64_t carry = 0;
+  for (int i = *len - 1; i >= 0; i--) {
+    uint64_t cur = (uint64_t)limbs[i] * 1000000000u + carry;
+    limbs[i] = (uint32_t)cur;
+    carry = cur >> 32;
+  }
+  // the low bits move up by 9 each time, trailing limbs run out
+  while (*len && !limbs[*len - 1]) {
+    (*len)--;
+  }
+  return (uint32_t)carry;
+}
+
+// Place m * 2^shift (shift below 32) in limbs word .. word + 2, least significant first
+static void big_place(uint32_t *limbs, int len, int word, uint64_t m, int shift) {
+  uint32_t parts[3] = {
+    (uint32_t)(m << shift),
+    (uint32_t)(m >> (32 - shift)),
+    (uint32_t)(shift ? m >> (64 - shift) : 0)
+  };
+  for (int i = 0; i < 3; i++) {
+    if (word + i >= 0 && word + i < len) {
+      limbs[word + i] = parts[i];
+    }
+  }
+}
+
+// Append the nine digits of chunk. While nothing is stored leading zeros are
+// skipped instead, each moving the decimal point one further left.
+static void put_chunk(char *digits, int *count, int *point, uint32_t chunk, int width) {
+  char buffer[9];
+  for (int i = width - 1; i >= 0; i--) {
+    buffer[i] = '0' + (char)(chunk % 10);
+    chunk /= 10;
+  }
+  for (int i = 0; i < width; i++) {
+    if (*count == 0 && buffer[i] == '0') {
+      (*point)--;
       continue;
     }
+    digits[(*count)++] = buffer[i];
+  }
+}
+
+/**
+ * Exact digits of a finite, positive double, value = 0.digits * 10^point,
+ * generated until there are more than places significant digits (places
+ * after the decimal point if fixed) or the expansion ends. *inexact is set
+ * if nonzero digits follow the ones returned. Needs DTOA_EXACT_MAX digits.
+ */
+static int dtoa_exact(double value, int fixed, int places, char *digits, int *point, int *inexact) {
+  union { double d; uint64_t u; } bits = {value};
+  int biased = (int)((bits.u >> 52) & 0x7FF);
+  uint64_t m = bits.u & DP_SIGNIFICAND_MASK;
+  int e = biased ? biased - DP_EXPONENT_BIAS : 1 - DP_EXPONENT_BIAS;
+  uint32_t limbs[EXACT_LIMBS];
+  int count = 0, len;
+
+  *inexact = 0;
+  if (biased) {
+    m += DP_HIDDEN_BIT;
+  }
+  else if (!m) {
+    digits[0] = '0';
+    *point = 1;
+    return 1;
+  }
 
-    string++;  // Skip '%'
-    char temp_buffer[MAX_PRINT_SIZE];
-    int temp_index = MAX_PRINT_SIZE - 1;
-    int zeroPad = 0, width = 0, precision = -1;
+  // integer part, in 64 bits up to 2^64, beyond that as a bignum split into 10^9 chunks
+  if (e > 11) {
+    uint32_t chunks[EXACT_LIMBS];
+    int n = 0;
 
-    if (*string == '0') {
-      zeroPad = 1;
-      string++;
+    len = e / 32 + 3;
+    for (int i = 0; i < len; i++) {
+      limbs[i] = 0;
+    }
+    big_place(limbs, len, e / 32, m, e % 32);
+    while (!limbs[len - 1]) {
+      len--;
+    }
+    while (len) {
+      chunks[n++] = big_div_1e9(limbs, &len);
     }
 
-    while (*string >= '0' && *string <= '9') {
-      width = width * 10 + (*string - '0');
-      string++;
+    char buffer[INT_BUFFER_SIZE];
+    char *end = buffer + INT_BUFFER_SIZE;
+    for (char *d = utoa_dec(chunks[--n], end); d < end; d++) {
+      digits[count++] = *d;
+    }
+    while (n) {
+      put_chunk(digits, &count, point, chunks[--n], 9);
     }
+  }
+  else {
+    uint64_t integer = e >= 0 ? m << e : (-e < 53 ? m >> -e : 0);
+    if (integer) {
+      char buffer[INT_BUFFER_SIZE];
+      char *end = buffer + INT_BUFFER_SIZE;
+      for (char *d = utoa_dec(integer, end); d < end; d++) {
+        digits[count++] = *d;
+      }
+    }
+  }
+  *point = count;
+
+  // fraction, the bits below the point left aligned from limbs[0] down
+  int fbits = e < 0 ? -e : 0;
+  uint64_t fraction = fbits >= 53 ? m : m & ((1ULL << fbits) - 1);
+  len = (fbits + 31) / 32;
+  for (int i = 0; i < len; i++) {
+    limbs[i] = 0;
+  }
+  // limbs[len - 1] is the least significant here, the parts go in backwards
+  uint32_t parts[3];
+  big_place(parts, 3, 0, fraction, 32 * len - fbits);
+  for (int i = 0; i < 3 && i < len; i++) {
+    limbs[len - 1 - i] = parts[i];
+  }
+  while (len && !limbs[len - 1]) {
+    len--;
+  }
+
+  while (len && (count == 0 || count <= (fixed ? *point + places : places))) {
+    put_chunk(digits, &count, point, frac_mul_1e9(limbs, &len), 9);
+  }
+  *inexact = len != 0;
+  return count;
+}
+
+/**
+ * Fetch the argument a conversion consumes, returns 0 for conversions that
+ * take none (%% and unknown ones)
+ */
+static int fetch_arg(const FmtSpec *spec, va_list *ap, FmtArg *arg) {
+  int wide = spec->length == FMT_LEN_LONG;
+
+  if (!fmt_takes_arg(spec->conv)) {
+    return 0;
+  }
+
+  switch (spec->conv) {
+  case 'd':
+  case 'i':
+  case 'c':
+    arg->i = wide ? va_arg(*ap, long) : va_arg(*ap, int);
+    return 1;
+
+  case 'u':
+  case 'x':
+  case 'X':
+  case 'o':
+  case 'b':
+    arg->u = wide ? va_arg(*ap, unsigned long) : va_arg(*ap, unsigned int);
+    return 1;
+
+  case 'p':
+    arg->p = va_arg(*ap, void *);
+    return 1;
+
+  case 's':
+    arg->s = va_arg(*ap, const char *);
+    return 1;
+
+  default:  // f F e E g G
+    arg->d = va_arg(*ap, double);
+    return 1;
+  }
+}
+
+// Emit a converted number: sign/prefix, zero or space padding, precision zeros, digits
+static void out_number(PrintOut *out, const char *prefix, const char *digits, int count,
+                       int width, int precision, int zeroPad) {
+  int prefixLen = 0;
+  int zeros = precision > count ? precision - count : 0;
+
+  while (prefix[prefixLen]) {
+    prefixLen++;
+  }
+
+  if (zeroPad && precision < 0) {
+    zeros = width - prefixLen - count;
+  }
+  else {
+    add_padding(out, prefixLen + zeros + count, width, 0);
+  }
+
+  out_str(out, prefix, prefixLen);
+  while (zeros-- > 0) {
+    out_char(out, '0');
+  }
+  out_str(out, digits, count);
+}
+
+// Round the decimal digits to keep significant digits, ties to even. inexact
+// says nonzero digits follow the stored ones, so a 5 is above the tie.
+// Updates the count and the position of the decimal point.
+static void round_digits(char *digits, int *count, int *point, int keep, int inexact) {
+  if (keep >= *count) {
+    return;
+  }
+  if (keep < 0) {
+    digits[0] = '0';
+    *count = 1;
+    return;
+  }
+
+  int up = digits[keep] > '5';
+  if (digits[keep] == '5') {
+    int tail = 0;
+    for (int i = keep + 1; i < *count; i++) {
+      tail |= digits[i] != '0';
+    }
+    up = tail || inexact || (keep > 0 && (digits[keep - 1] - '0') & 1);
+  }
+
+  *count = keep;
+  if (up) {
+    int i = keep - 1;
+    while (i >= 0 && digits[i] == '9') {
+      digits[i--] = '0';
+    }
+    if (i >= 0) {
+      digits[i]++;
+    }
+    else {
+      // carried out of the top digit: 999 -> 1000
+      digits[0] = '1';
+      *count = 1;
+      (*point)++;
+    }
+  }
+
+  if (*count == 0) {
+    digits[0] = '0';
+    *count = 1;
+  }
+}
+
+static int exponent_length(int exp10) {
+  int magnitude = exp10 < 0 ? -exp10 : exp10;
+  return 2 + (magnitude >= 100 ? 3 : 2);
+}
+
+// Emit e+XX (at least two exponent digits)
+static void out_exponent(PrintOut *out, int exp10, char letter) {
+  char buffer[INT_BUFFER_SIZE];
+  char *end = buffer + INT_BUFFER_SIZE;
+  char *digits = utoa_dec(exp10 < 0 ? -exp10 : exp10, end);
+
+  out_char(out, letter);
+  out_char(out, exp10 < 0 ? '-' : '+');
+  if (end - digits < 2) {
+    out_char(out, '0');
+  }
+  out_str(out, digits, end - digits);
+}
+
+// Digit at position index of digits, zero outside the stored ones
+static char digit_at(const char *digits, int count, int index) {
+  return (index >= 0 && index < count) ? digits[index] : '0';
+}
+
+// %f %e %g (and upper case). The shortest round-trip digits serve when they
+// fit the precision, otherwise the exact expansion is rounded.
+static void out_float(PrintOut *out, double value, char conv, int width, int precision, int zeroPad) {
+  union { double d; uint64_t u; } bits = {value};
+  const char *sign = (bits.u >> 63) ? "-" : "";
+  int upper = conv == 'F' || conv == 'E' || conv == 'G';
+  char lower = conv | 0x20;
+  int signLen = *sign ? 1 : 0;
 
-    if (*string == '.') {
-      precision = 0;
-      string++;
-      while (*string >= '0' && *string <= '9') {
-        precision = precision * 10 + (*string - '0');
-        string++;
+  if (((bits.u >> 52) & 0x7FF) == 0x7FF) {
+    const char *text = (bits.u & DP_SIGNIFICAND_MASK) ? (upper ? "NAN" : "nan") : (upper ? "INF" : "inf");
+    add_padding(out, signLen + 3, width, 0);
+    out_str(out, sign, signLen);
+    out_str(out, text, 3);
+    return;
+  }
+
+  if (precision < 0) {
+    precision = 6;
+  }
+  if (lower == 'g' && precision == 0) {
+    precision = 1;
+  }
+
+  double magnitude = *sign ? -value : value;
+  char digits[DTOA_EXACT_MAX];
+  int exp10, inexact = 0;
+  int count = dtoa_shortest(magnitude, digits, &exp10);
+  int point = count + exp10;  // digits before the decimal point
+  int fixed = lower == 'f';
+  int places = lower == 'e' ? precision + 1 : precision;
+  int keep = fixed ? point + places : places;
+  int fraction;
+
+  // For a normal double the shortest digits are within half an ulp, far
+  // closer than half a unit in the 15th digit, so as they stand they are the
+  // correctly rounded result. Subnormals have fewer significant bits.
+  int normal = ((bits.u >> 52) & 0x7FF) != 0;
+  if (count > keep || keep > DTOA_FAST_DIGITS || !normal) {
+    count = dtoa_exact(magnitude, fixed, places, digits, &point, &inexact);
+    keep = fixed ? point + places : places;
+  }
+  round_digits(digits, &count, &point, keep, inexact);
+
+  if (lower == 'g') {
+    int x = digits[0] == '0' ? 0 : point - 1;
+    fixed = x >= -4 && x < precision;
+
+    // %g drops trailing zeros
+    while (count > 1 && digits[count - 1] == '0') {
+      count--;
+    }
+    if (fixed) {
+      fraction = count - point;
+      if (fraction < 0) {
+        fraction = 0;
       }
     }
+    else {
+      fraction = count - 1;
+    }
+  }
+  else {
+    fraction = precision;
+  }
+
+  int zero = digits[0] == '0';
+  int length;
+  if (fixed) {
+    length = (point > 0 ? point : 1) + (fraction ? fraction + 1 : 0);
+  }
+  else {
+    length = 1 + (fraction ? fraction + 1 : 0) + exponent_length(zero ? 0 : point - 1);
+  }
 
-    int count = 0;
+  if (!zeroPad) {
+    add_padding(out, signLen + length, width, 0);
+  }
+  out_str(out, sign, signLen);
+  if (zeroPad) {
+    add_padding(out, signLen + length, width, 1);
+  }
 
-    // Handle format specifiers
-    switch (*string++) {
-    case 'd':
-    case 'x':
-      int base = (*string == 'x') ? 16 : 10;
-      int num = va_arg(ap, int);
-      itoa(num, temp_buffer, &temp_index, base);
-      count = MAX_PRINT_SIZE - 1 - temp_index;
-      add_padding(buffer, &buffer_index, count, width, zeroPad);
-      for (int i = temp_index + 1; i < MAX_PRINT_SIZE; i++) {
-          buffer[buffer_index++] = temp_buffer[i];
+  if (fixed) {
+    if (point > 0) {
+      for (int i = 0; i < point; i++) {
+        out_char(out, digit_at(digits, count, i));
       }
-      break;
-    
-    case 's': 
-      char *str = va_arg(ap, char *);
-      while(*str && (precision == -1 || count < precision)){
-        buffer[buffer_index++] = *str++;
-        count++;
+    }
+    else {
+      out_char(out, '0');
+    }
+    if (fraction) {
+      out_char(out, '.');
+      for (int i = 0; i < fraction; i++) {
+        out_char(out, digit_at(digits, count, point + i));
       }
-      add_padding(buffer, &buffer_index, count, width, zeroPad);
-      break;
-      
-    case 'c': 
-      char c = (char)va_arg(ap, int);  // char is promoted to int in variadic functions
-      buffer[buffer_index++] = c;
-      add_padding(buffer, &buffer_index, 1, width, zeroPad);
+    }
+  }
+  else {
+    out_char(out, digits[0]);
+    if (fraction) {
+      out_char(out, '.');
+      for (int i = 1; i <= fraction; i++) {
+        out_char(out, digit_at(digits, count, i));
+      }
+    }
+    out_exponent(out, zero ? 0 : point - 1, upper ? 'E' : 'e');
+  }
+}
+
+// Emit one parsed conversion of an argument fetched by fetch_arg
+static void out_spec(PrintOut *out, const FmtSpec *spec, FmtArg arg) {
+  char temp_buffer[INT_BUFFER_SIZE];
+  char *end = temp_buffer + INT_BUFFER_SIZE;
+  char *digits;
+  const char *prefix = "";
+  int count = 0;
+
+  // Handle format specifiers
+  switch (spec->conv) {
+  case 'd':
+  case 'i': {
+    int64_t num = arg.i;
+    uint64_t magnitude = num < 0 ? -(uint64_t)num : (uint64_t)num;
+    digits = utoa_dec(magnitude, end);
+    prefix = num < 0 ? "-" : "";
+    out_number(out, prefix, digits, end - digits, spec->width, spec->precision, spec->zeroPad);
+    break;
+  }
+
+  case 'u':
+    digits = utoa_dec(arg.u, end);
+    out_number(out, prefix, digits, end - digits, spec->width, spec->precision, spec->zeroPad);
+    break;
+
+  case 'x':
+    digits = utoa_pow2(arg.u, end, 4, lowerDigits);
+    out_number(out, prefix, digits, end - digits, spec->width, spec->precision, spec->zeroPad);
+    break;
+
+  case 'X':
+    digits = utoa_pow2(arg.u, end, 4, upperDigits);
+    out_number(out, prefix, digits, end - digits, spec->width, spec->precision, spec->zeroPad);
+    break;
+
+  case 'o':
+    digits = utoa_pow2(arg.u, end, 3, lowerDigits);
+    out_number(out, prefix, digits, end - digits, spec->width, spec->precision, spec->zeroPad);
+    break;
+
+  case 'b':
+    digits = utoa_pow2(arg.u, end, 1, lowerDigits);
+    out_number(out, prefix, digits, end - digits, spec->width, spec->precision, spec->zeroPad);
+    break;
+
+  case 'p':
+    digits = utoa_pow2((uintptr_t)arg.p, end, 4, lowerDigits);
+    out_number(out, "0x", digits, end - digits, spec->width, spec->precision, spec->zeroPad);
+    break;
+
+  case 'f':
+  case 'F':
+  case 'e':
+  case 'E':
+  case 'g':
+  case 'G':
+    out_float(out, arg.d, spec->conv, spec->width, spec->precision, spec->zeroPad);
+    break;
+
+  case 's': {
+    const char *str = arg.s;
+    if (!str) {
+      str = "(null)";
+    }
+    while (str[count] && (spec->precision == -1 || count < spec->precision)) {
+      count++;
+    }
+    out_str(out, str, count);
+    add_padding(out, count, spec->width, spec->zeroPad);
+    break;
+  }
+
+  case 'c': {
+    char c = (char)arg.i;  // char is promoted to int in variadic functions
+    out_char(out, c);
+    add_padding(out, 1, spec->width, spec->zeroPad);
+    break;
+  }
+
+  case '%':
+    out_char(out, '%');
+    break;
+
+  case '\0':
+    // Format string ended right after '%'
+    out_char(out, '%');
+    break;
+
+  default:
+    out_char(out, '%');  // Handle unknown format specifiers
+    out_char(out, spec->conv);
+  }
+}
+
+static void out_init(PrintOut *out, PrintSink sink, void *ctx) {
+  out->sink = sink;
+  out->ctx = ctx;
+  out->len = 0;
+  out->total = 0;
+}
+
+// Formatter core, streams the output to the sink in PRINT_CHUNK_SIZE pieces
+int vcprintf(PrintSink sink, void *ctx, const char *string, va_list args) {
+  // local copy so the conversions can take its address on any ABI
+  va_list ap;
+  va_copy(ap, args);
+  PrintOut out;
+  FmtSpec spec;
+  FmtArg arg;
+  out_init(&out, sink, ctx);
+
+  while (*string) {
+    if (*string != '%') {
+      out_char(&out, *string++);
+      continue;
+    }
+
+    string = fmt_parse_spec(string, &spec);
+    fetch_arg(&spec, &ap, &arg);
+    out_spec(&out, &spec, arg);
+  }
+
+  va_end(ap);
+  out_flush(&out);
+  return out.total;
+}
+
+// Same output as vcprintf, walking a format parsed at build time (see cli/formats.h)
+int vcprintf_program(PrintSink sink, void *ctx, const FmtProgram *program, va_list args) {
+  va_list ap;
+  va_copy(ap, args);
+  PrintOut out;
+  const char *text = program->text;
+  FmtArg arg;
+  out_init(&out, sink, ctx);
+
+  for (uint16_t i = 0; i < program->count; i++) {
+    const FmtSpec *spec = &program->specs[i];
+    out_str(&out, text, spec->literal);
+    text += spec->literal + spec->skip;
+    if (spec->conv) {
+      fetch_arg(spec, &ap, &arg);
+      out_spec(&out, spec, arg);
+    }
+  }
+
+  va_end(ap);
+  out_flush(&out);
+  return out.total;
+}
+
+/**
+ * Save the arguments of a format so it can be printed later by another core.
+ * %s strings are copied into strings (cut to fit), so callers may pass
+ * buffers that go away. Returns the argument count, or -1 if there are more
+ * than max.
+ */
+int fmt_capture(const char *string, va_list args, FmtArg *out, int max, char *strings, size_t size) {
+  va_list ap;
+  va_copy(ap, args);
+  FmtSpec spec;
+  int count = 0;
+  size_t used = 0;
+
+  while (*string) {
+    if (*string++ != '%') {
+      continue;
+    }
+
+    string = fmt_parse_spec(string - 1, &spec);
+    FmtArg arg;
+    if (!fetch_arg(&spec, &ap, &arg)) {
+      continue;
+    }
+    if (count == max) {
+      count = -1;
       break;
-    
-    default:
-      buffer[buffer_index++] = '%';  // Handle unknown format specifiers
-      if(*string) {
-        buffer[buffer_index++] = *string;
+    }
+
+    if (spec.conv == 's') {
+      const char *str = arg.s ? arg.s : "(null)";
+      arg.s = strings + used;
+      while (*str && used + 1 < size) {
+        strings[used++] = *str++;
+      }
+      if (used < size) {
+        strings[used++] = '\0';
       }
     }
+    out[count++] = arg;
   }
 
-  buffer[buffer_index] = '\0';  // Ensure null termination
-  uart_puts(buffer);  // Function to send the buffer to UART
   va_end(ap);
-}
\ No newline at end of file
+  return count;
+}
+
+// vcprintf with the arguments saved by fmt_capture
+int vcprintf_args(PrintSink sink, void *ctx, const char *string, const FmtArg *args, int count) {
+  PrintOut out;
+  FmtSpec spec;
+  FmtArg none = {0};
+  int next = 0;
+  out_init(&out, sink, ctx);
+
+  while (*string) {
+    if (*string != '%') {
+      out_char(&out, *string++);
+      continue;
+    }
+
+    string = fmt_parse_spec(string, &spec);
+    out_spec(&out, &spec, next < count ? args[next] : none);
+    if (fmt_takes_arg(spec.conv)) {
+      next++;
+    }
+  }
+
+  out_flush(&out);
+  return out.total;
+}
+
+// Sink fanning out to every registered console sink
+static void console_out(void *ctx, const char *data, size_t len) {
+  console_write(data, len);
+}
+
+int vprintf(const char *string, va_list ap) {
+  return vcprintf(console_out, NULL, string, ap);
+}
+
+// Main printf function
+int printf(const char *string, ...) {
+  va_list ap;
+  va_start(ap, string);
+  int len = vprintf(string, ap);
+  va_end(ap);
+  return len;
+}
+
+// Sink filling a caller buffer, output beyond the buffer is counted but dropped
+typedef struct {
+  char *buffer;
+  size_t size;
+  size_t pos;
+} MemorySink;
+
+static void memory_sink(void *ctx, const char *data, size_t len) {
+  MemorySink *mem = (MemorySink *)ctx;
+  while (len-- && mem->pos + 1 < mem->size) {
+    mem->buffer[mem->pos++] = *data++;
+  }
+}
+
+int vsnprintf(char *buffer, size_t size, const char *string, va_list ap) {
+  MemorySink mem = {buffer, size, 0};
+  int len = vcprintf(memory_sink, &mem, string, ap);
+  if (size) {
+    buffer[mem.pos] = '\0';
+  }
+  return len;
+}
+
+int snprintf(char *buffer, size_t size, const char *string, ...) {
+  va_list ap;
+  va_start(ap, string);
+  int len = vsnprintf(buffer, size, string, ap);
+  va_end(ap);
+  return len;
+}
+
+int printf_args(const char *string, const FmtArg *args, int count) {
+  return vcprintf_args(console_out, NULL, string, args, count);
+}
+
+int printf_program(const FmtProgram *program, ...) {
+  va_list ap;
+  va_start(ap, program);
+  int len = vcprintf_program(console_out, NULL, program, ap);
+  va_end(ap);
+  return len;
+}
+
+int snprintf_program(char *buffer, size_t size, const FmtProgram *program, ...) {
+  MemorySink mem = {buffer, size, 0};
+  va_list ap;
+  va_start(ap, program);
+  int len = vcprintf_program(memory_sink, &mem, program, ap);
+  va_end(ap);
+  if (size) {
+    buffer[mem.pos] = '\0';
+  }
+  return len;
+}
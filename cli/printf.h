@@ -4,7 +4,69 @@
 #include "../gcclib/stddef.h"
 #include "../gcclib/stdint.h"
 #include "../gcclib/stdarg.h"
+#include "fmtparse.h"
+#include "formats.h"
 
-void printf(const char *string, ...);
+// Scratch space for one integer conversion (64 binary digits)
+#define INT_BUFFER_SIZE 66
 
-#endif
\ No newline at end of file
+// Receives formatted output in chunks (not NUL terminated)
+typedef void (*PrintSink)(void *ctx, const char *data, size_t len);
+
+// Integer conversions, digits are written backwards ending at end
+char *utoa_dec(uint64_t num, char *end);
+char *utoa_pow2(uint64_t num, char *end, int shift, const char *digits);
+
+// Shortest round-trip digits of a finite, positive double (Grisu2).
+// %f %e %g print these when they fit the precision, otherwise they round the
+// exact decimal expansion of the double (ties to even).
+#define DTOA_DIGITS_MAX 18
+int dtoa_shortest(double value, char *digits, int *exp10);
+
+int vcprintf(PrintSink sink, void *ctx, const char *string, va_list ap)
+  __attribute__((format(__printf__, 3, 0)));
+int vprintf(const char *string, va_list ap) __attribute__((format(__printf__, 1, 0)));
+int printf(const char *string, ...) __attribute__((format(__printf__, 1, 2)));
+int vsnprintf(char *buffer, size_t size, const char *string, va_list ap)
+  __attribute__((format(__printf__, 3, 0)));
+int snprintf(char *buffer, size_t size, const char *string, ...)
+  __attribute__((format(__printf__, 3, 4)));
+
+// One argument saved by fmt_capture
+typedef union {
+  int64_t i;
+  uint64_t u;
+  double d;
+  const char *s;
+  void *p;
+} FmtArg;
+
+// Deferred formatting: save the arguments now, print them later (or on another core)
+int fmt_capture(const char *string, va_list ap, FmtArg *args, int max, char *strings, size_t size);
+int vcprintf_args(PrintSink sink, void *ctx, const char *string, const FmtArg *args, int count);
+int printf_args(const char *string, const FmtArg *args, int count);
+
+// Formats parsed at build time by tools/fmtgen, see cli/formats.h
+int vcprintf_program(PrintSink sink, void *ctx, const FmtProgram *program, va_list ap);
+int printf_program(const FmtProgram *program, ...);
+int snprintf_program(char *buffer, size_t size, const FmtProgram *program, ...);
+
+// Never called, lets the compiler check the arguments against the format text
+static inline __attribute__((format(__printf__, 1, 2))) void fmt_check(const char *string, ...) {
+  (void)string;
+}
+
+/*
+ * PRINTF_FMT(ID, args...) prints FMT_ID from cli/formats.h through its
+ * pre-parsed program. The arguments are type checked against FMT_ID but
+ * evaluated only once.
+ */
+#define PRINTF_FMT(id, ...) \
+  ((0 ? fmt_check(FMT_##id, ##__VA_ARGS__) : (void)0), \
+   printf_program(&fmtProgram_##id, ##__VA_ARGS__))
+
+#define SNPRINTF_FMT(buffer, size, id, ...) \
+  ((0 ? fmt_check(FMT_##id, ##__VA_ARGS__) : (void)0), \
+   snprintf_program(buffer, size, &fmtProgram_##id, ##__VA_ARGS__))
+
+#endif
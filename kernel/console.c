@@ -0,0 +1,268 @@
+#include "console.h"
+#include "string.h"
+#include "cpu.h"
+#include "plog.h"
+#include "../uart/uart.h"
+
+// Line being assembled by one core, one slot of a lane
+typedef struct {
+  char data[CONSOLE_LINE_SIZE];
+  size_t len;
+} __attribute__((aligned(CACHE_LINE_SIZE))) ConsoleLine;
+
+// Complete lines from one core, head and tail sit on their own cache lines
+typedef struct {
+  ConsoleLine slots[CONSOLE_LANE_SLOTS];
+  struct {
+    volatile unsigned long head;  // written by the producing core only
+    unsigned long dropped;
+  } __attribute__((aligned(CACHE_LINE_SIZE))) producer;
+  struct {
+    volatile unsigned long tail;  // written by the owner core only
+  } __attribute__((aligned(CACHE_LINE_SIZE))) consumer;
+} ConsoleLane;
+
+static ConsoleLine lineBuffers[CPU_CORES];
+static ConsoleLane lanes[CPU_CORES];  // the owner's lane stays empty
+
+// Core that drains the lanes and drives the sinks
+static volatile unsigned int consoleOwner = 0;
+
+// Completed console_flush calls on the owner, console_sync waits for one
+static volatile unsigned long flushPasses = 0;
+
+static ConsoleSink sinks[CONSOLE_MAX_SINKS];
+static int sinkCount = 0;
+
+/**
+ * Register the boot sinks. The persistent log ring goes first: it never
+ * blocks, so it holds the text before a slow UART starts draining.
+ */
+void console_init() {
+  console_register("plog", plog_write, CONSOLE_BUFFER_NONE);
+  console_register("uart", uart_write, CONSOLE_BUFFER_LINE);
+}
+
+/**
+ * Add a sink, returns its index or -1 if the table is full
+ */
+int console_register(const char *name, ConsoleWrite write, int policy) {
+  if (sinkCount == CONSOLE_MAX_SINKS)
+    return -1;
+
+  ConsoleSink *sink = &sinks[sinkCount];
+  sink->name = name;
+  sink->write = write;
+  sink->policy = policy;
+  sink->enabled = 1;
+  sink->len = 0;
+  sink->bytes = 0;
+  sink->flushes = 0;
+  return sinkCount++;
+}
+
+ConsoleSink *console_find(const char *name) {
+  for (int i = 0; i < sinkCount; i++) {
+    if (strcmp(sinks[i].name, name) == 0)
+      return &sinks[i];
+  }
+  return NULL;
+}
+
+int console_sink_count() {
+  return sinkCount;
+}
+
+ConsoleSink *console_sink(int index) {
+  return (index >= 0 && index < sinkCount) ? &sinks[index] : NULL;
+}
+
+static void sink_flush(ConsoleSink *sink) {
+  if (sink->len) {
+    sink->write(sink->buffer, sink->len);
+    sink->bytes += sink->len;
+    sink->flushes++;
+    sink->len = 0;
+  }
+}
+
+/**
+ * Change the flush policy, anything already buffered goes out first
+ */
+void console_set_policy(ConsoleSink *sink, int policy) {
+  sink_flush(sink);
+  sink->policy = policy;
+}
+
+void console_enable(ConsoleSink *sink, int enabled) {
+  if (!enabled)
+    sink_flush(sink);
+  sink->enabled = enabled;
+}
+
+static void sink_put(ConsoleSink *sink, const char *data, size_t len) {
+  if (sink->policy == CONSOLE_BUFFER_NONE) {
+    sink->write(data, len);
+    sink->bytes += len;
+    sink->flushes++;
+    return;
+  }
+
+  while (len--) {
+    char c = *data++;
+    sink->buffer[sink->len++] = c;
+    if (sink->len == CONSOLE_SINK_BUFFER || (c == '\n' && sink->policy == CONSOLE_BUFFER_LINE))
+      sink_flush(sink);
+  }
+}
+
+// Hand one line to every enabled sink (owner core only)
+static void fan_out(const char *data, size_t len) {
+  for (int i = 0; i < sinkCount; i++) {
+    if (sinks[i].enabled)
+      sink_put(&sinks[i], data, len);
+  }
+}
+
+// Copy a line into the core's lane. If the owner hasn't caught up the line
+// is dropped, or on the shell's core waits for a free slot. The shell's core
+// receives for the console UART, it keeps doing so while it waits in case
+// the owner is held up by an XOFF only the receiver sees.
+static void lane_commit(unsigned int core, ConsoleLine *line) {
+  ConsoleLane *lane = &lanes[core];
+  unsigned long head = lane->producer.head;
+
+  while (head - lane->consumer.tail == CONSOLE_LANE_SLOTS) {
+    if (core != CONSOLE_CLI_CORE) {
+      lane->producer.dropped++;
+      return;
+    }
+    uart_poll();
+  }
+
+  ConsoleLine *slot = &lane->slots[head & (CONSOLE_LANE_SLOTS - 1)];
+  for (size_t i = 0; i < line->len; i++) {
+    slot->data[i] = line->data[i];
+  }
+  slot->len = line->len;
+
+  // the slot must be complete before the owner can see the new head
+  cpu_dmb();
+  lane->producer.head = head + 1;
+}
+
+// Move every queued line from the other cores into the sinks (owner core only)
+static void console_drain() {
+  for (int i = 0; i < CPU_CORES; i++) {
+    ConsoleLane *lane = &lanes[i];
+    unsigned long tail = lane->consumer.tail;
+
+    while (tail != lane->producer.head) {
+      // read the head before the slot it publishes
+      cpu_dmb();
+      ConsoleLine *slot = &lane->slots[tail & (CONSOLE_LANE_SLOTS - 1)];
+      fan_out(slot->data, slot->len);
+
+      // done with the slot before handing it back
+      cpu_dmb();
+      lane->consumer.tail = ++tail;
+    }
+  }
+}
+
+static void line_commit(unsigned int core, ConsoleLine *line) {
+  if (!line->len)
+    return;
+
+  if (core == consoleOwner) {
+    console_drain();
+    fan_out(line->data, line->len);
+  }
+  else {
+    lane_commit(core, line);
+  }
+  line->len = 0;
+}
+
+/**
+ * Append to the calling core's line buffer, complete lines are passed on
+ */
+void console_write(const char *data, size_t len) {
+  unsigned int core = cpu_id();
+  ConsoleLine *line = &lineBuffers[core];
+
+  while (len--) {
+    char c = *data++;
+    line->data[line->len++] = c;
+    if (c == '\n' || line->len == CONSOLE_LINE_SIZE)
+      line_commit(core, line);
+  }
+}
+
+/**
+ * Pass on the calling core's partial line. On the owner also drain the lanes and
+ * push out whatever the sinks are holding, call before waiting for input.
+ */
+void console_flush() {
+  unsigned int core = cpu_id();
+
+  line_commit(core, &lineBuffers[core]);
+  if (core != consoleOwner)
+    return;
+
+  console_drain();
+  for (int i = 0; i < sinkCount; i++) {
+    if (sinks[i].enabled)
+      sink_flush(&sinks[i]);
+  }
+  cpu_dmb();
+  flushPasses++;
+}
+
+/**
+ * console_flush, and off the owner also wait until the owner has written
+ * everything this core queued, e.g. before changing the UART line settings.
+ * Blocks by design (see console.h), receiving for the console UART meanwhile.
+ */
+void console_sync() {
+  unsigned int core = cpu_id();
+  ConsoleLane *lane = &lanes[core];
+
+  console_flush();
+  if (core == consoleOwner)
+    return;
+
+  while (lane->consumer.tail != lane->producer.head) {
+    uart_poll();
+  }
+  // the line may still sit in a sink buffer, the next finished pass flushed it
+  unsigned long pass = flushPasses;
+  while (flushPasses == pass) {
+    uart_poll();
+  }
+}
+
+/**
+ * Lines lost because a lane was full
+ */
+unsigned long console_lines_dropped() {
+  unsigned long dropped = 0;
+  for (int i = 0; i < CPU_CORES; i++) {
+    dropped += lanes[i].producer.dropped;
+  }
+  return dropped;
+}
+
+/**
+ * Hand the sinks to another core (the I/O core). Call on the current owner
+ * after console_flush, its later output goes through its lane.
+ */
+void console_set_owner(unsigned int core) {
+  cpu_dmb();
+  consoleOwner = core;
+  cpu_dmb();
+}
+
+unsigned int console_owner() {
+  return consoleOwner;
+}
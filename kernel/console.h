@@ -0,0 +1,72 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include "../gcclib/stddef.h"
+#include "../gcclib/stdint.h"
+
+/*
+ * Console fan-out
+ * Every console_write is copied to each registered sink. Sinks keep their own
+ * buffer and flush policy, so a fully buffered or unbuffered sink doesn't wait
+ * on a line buffered one and vice versa.
+ *
+ * Each core assembles its output in its own line buffer. Other cores commit
+ * complete lines into a per-core lane (single producer, single consumer),
+ * which the owner core drains into the sinks. Lines from different cores
+ * never interleave. A full lane drops the line and counts it, no core waits
+ * on another core's output, with one exception below. Sinks are only ever
+ * touched by the owner, core 0 until the I/O core (kernel/iocore.c) takes over.
+ *
+ * The shell's core (CONSOLE_CLI_CORE) blocks on console output. Its lines are
+ * replies to the user: help or dmesg queue far more than a lane holds faster
+ * than 115200 baud sends them, and tools/baudswitch.py waits for an exact ACK
+ * line, so dropping them loses output the user asked for. A full lane makes it
+ * wait for the owner to free a slot instead. console_sync waits as well, on any
+ * core but the owner, until the owner has written everything the core queued:
+ * its callers are about to change the UART line settings or the console port,
+ * and lines still queued would go out garbled or to the wrong port. The shell
+ * has nothing else to do meanwhile, and it keeps receiving while it waits (see
+ * lane_commit). The wait lasts only as long as the owner takes to send the
+ * backlog.
+ */
+
+#define CONSOLE_MAX_SINKS    4
+#define CONSOLE_SINK_BUFFER  256
+#define CONSOLE_LINE_SIZE    120    // line data, with the length fills one 128 byte slot
+#define CONSOLE_LANE_SLOTS   32     // lines queued per core, power of two
+#define CONSOLE_CLI_CORE     0      // runs the shell, blocks for lane space rather than drop
+
+// Flush policies
+#define CONSOLE_BUFFER_NONE  0   // pass every write straight through
+#define CONSOLE_BUFFER_LINE  1   // flush on '\n' or when the buffer is full
+#define CONSOLE_BUFFER_FULL  2   // flush only when the buffer is full or on console_flush
+
+typedef void (*ConsoleWrite)(const char *data, size_t len);
+
+typedef struct {
+  const char *name;
+  ConsoleWrite write;
+  int policy;
+  int enabled;
+  char buffer[CONSOLE_SINK_BUFFER];
+  size_t len;
+  unsigned long bytes;    // bytes handed to write()
+  unsigned long flushes;  // calls to write()
+} ConsoleSink;
+
+void console_init();
+int console_register(const char *name, ConsoleWrite write, int policy);
+ConsoleSink *console_find(const char *name);
+int console_sink_count();
+ConsoleSink *console_sink(int index);
+void console_set_policy(ConsoleSink *sink, int policy);
+void console_enable(ConsoleSink *sink, int enabled);
+
+void console_write(const char *data, size_t len);
+void console_flush();
+void console_sync();
+unsigned long console_lines_dropped();
+void console_set_owner(unsigned int core);
+unsigned int console_owner();
+
+#endif
@@ -0,0 +1,303 @@
+#ifndef CONTAINERS_H
+#define CONTAINERS_H
+
+#include "../gcclib/stddef.h"
+#include "../gcclib/stdint.h"
+
+/*
+ * Generic containers, instantiated per element type by macros:
+ *
+ *   HASHMAP_DEFINE(name, Key, Value, hashFn, equalFn)   Robin Hood hash map
+ *   RING_DEFINE(name, Type, size)                       power of two ring buffer
+ *   HEAP_DEFINE(name, Type, capacity, lessFn)           binary min-heap
+ *   ListNode                                            intrusive doubly linked list
+ *
+ * Each DEFINE makes a struct type called name and static inline functions
+ * name_init, name_... . Nothing allocates: the ring and the heap hold their
+ * elements, the map works in arrays its owner provides. None of them lock.
+ */
+
+// Pointer to the struct of type holding member at ptr
+#define container_of(ptr, type, member) ((type *)((char *)(ptr) - offsetof(type, member)))
+
+/*--------------------------------------Hash map-----------------------------------------
+ * Open addressing with linear probing, kept in Robin Hood order: an entry
+ * further from its home slot takes the place of one closer to home, so probe
+ * lengths stay short and a lookup stops as soon as it passes entries nearer
+ * home than it would be. Removal shifts the following run back by one, no
+ * tombstones.
+ *
+ * The probe walks a separate array of 32-bit slot tags (16 per cache line):
+ * probe distance + 1 in the low half (0 = empty) and 16 bits of the hash in
+ * the high half, so equalFn only runs on a tag match. Capacity is a power of
+ * two up to 65536; puts fail past 7/8 full.
+ *
+ *   uint64_t hashFn(Key key);  int equalFn(Key a, Key b);   (functions or macros)
+ */
+#define HASHMAP_TAG(dist, hash) ((uint32_t)(dist) | (uint32_t)((hash) >> 48) << 16)
+#define HASHMAP_DIST(tag)       ((tag) & 0xFFFF)
+#define HASHMAP_NONE            0xFFFFFFFFu
+
+#define HASHMAP_DEFINE(name, Key, Value, hashFn, equalFn) \
+typedef struct { \
+  Key key; \
+  Value value; \
+} name##_slot; \
+\
+typedef struct { \
+  uint32_t *tags; \
+  name##_slot *slots; \
+  uint32_t mask; \
+  uint32_t count; \
+} name; \
+\
+static inline void name##_init(name *map, name##_slot *slots, uint32_t *tags, uint32_t capacity) { \
+  map->tags = tags; \
+  map->slots = slots; \
+  map->mask = capacity - 1; \
+  map->count = 0; \
+  for (uint32_t i = 0; i < capacity; i++) \
+    tags[i] = 0; \
+} \
+\
+/* slot index of key, HASHMAP_NONE if absent */ \
+static inline uint32_t name##_index(const name *map, Key key) { \
+  uint64_t hash = hashFn(key); \
+  uint32_t want = HASHMAP_TAG(1, hash); \
+  for (uint32_t i = (uint32_t)hash & map->mask;; i = (i + 1) & map->mask) { \
+    uint32_t tag = map->tags[i]; \
+    if (tag == want && equalFn(map->slots[i].key, key)) \
+      return i; \
+    if (HASHMAP_DIST(tag) < HASHMAP_DIST(want)) \
+      return HASHMAP_NONE; \
+    want++; \
+  } \
+} \
+\
+/** Value stored for key, NULL if absent */ \
+static inline Value *name##_find(name *map, Key key) { \
+  uint32_t i = name##_index(map, key); \
+  return i == HASHMAP_NONE ? NULL : &map->slots[i].value; \
+} \
+\
+/** Insert or replace, returns 0, or -1 if the map is full */ \
+static inline int name##_put(name *map, Key key, Value value) { \
+  uint32_t i = name##_index(map, key); \
+  if (i != HASHMAP_NONE) { \
+    map->slots[i].value = value; \
+    return 0; \
+  } \
+  if (map->count >= (map->mask + 1) - ((map->mask + 1) >> 3)) \
+    return -1; \
+\
+  uint64_t hash = hashFn(key); \
+  uint32_t tag = HASHMAP_TAG(1, hash); \
+  name##_slot carry; \
+  carry.key = key; \
+  carry.value = value; \
+  for (i = (uint32_t)hash & map->mask;; i = (i + 1) & map->mask, tag++) { \
+    uint32_t here = map->tags[i]; \
+    if (!here) \
+      break; \
+    if (HASHMAP_DIST(here) < HASHMAP_DIST(tag)) { \
+      /* take the slot from the entry nearer home, carry it on */ \
+      name##_slot moved = map->slots[i]; \
+      map->slots[i] = carry; \
+      map->tags[i] = tag; \
+      carry = moved; \
+      tag = here; \
+    } \
+  } \
+  map->slots[i] = carry; \
+  map->tags[i] = tag; \
+  map->count++; \
+  return 0; \
+} \
+\
+/** Returns 0, or -1 if key was absent */ \
+static inline int name##_remove(name *map, Key key) { \
+  uint32_t i = name##_index(map, key); \
+  if (i == HASHMAP_NONE) \
+    return -1; \
+  for (uint32_t next = (i + 1) & map->mask; HASHMAP_DIST(map->tags[next]) > 1; \
+       i = next, next = (next + 1) & map->mask) { \
+    map->slots[i] = map->slots[next]; \
+    map->tags[i] = map->tags[next] - 1; \
+  } \
+  map->tags[i] = 0; \
+  map->count--; \
+  return 0; \
+} \
+\
+/** Next occupied slot from *pos on, NULL at the end. Start with *pos = 0 */ \
+static inline name##_slot *name##_next(name *map, uint32_t *pos) { \
+  while (*pos <= map->mask) { \
+    uint32_t i = (*pos)++; \
+    if (map->tags[i]) \
+      return &map->slots[i]; \
+  } \
+  return NULL; \
+}
+
+/*--------------------------------------Ring buffer--------------------------------------
+ * head and tail run freely and are masked on access, so full and empty
+ * differ without a spare slot. Elements are stored in place.
+ */
+#define RING_DEFINE(name, Type, size) \
+_Static_assert(((size) & ((size) - 1)) == 0, #name " size must be a power of two"); \
+\
+typedef struct { \
+  uint32_t head;  /* next to write */ \
+  uint32_t tail;  /* next to read */ \
+  Type items[size]; \
+} name; \
+\
+static inline void name##_init(name *ring) { \
+  ring->head = ring->tail = 0; \
+} \
+\
+static inline uint32_t name##_count(const name *ring) { \
+  return ring->head - ring->tail; \
+} \
+\
+/** Returns 0, or -1 if the ring is full */ \
+static inline int name##_push(name *ring, const Type *item) { \
+  if (ring->head - ring->tail == (size)) \
+    return -1; \
+  ring->items[ring->head++ & ((size) - 1)] = *item; \
+  return 0; \
+} \
+\
+/** Push, dropping the oldest element if the ring is full */ \
+static inline void name##_push_over(name *ring, const Type *item) { \
+  if (ring->head - ring->tail == (size)) \
+    ring->tail++; \
+  ring->items[ring->head++ & ((size) - 1)] = *item; \
+} \
+\
+/** Returns 0, or -1 if the ring is empty */ \
+static inline int name##_pop(name *ring, Type *item) { \
+  if (ring->head == ring->tail) \
+    return -1; \
+  *item = ring->items[ring->tail++ & ((size) - 1)]; \
+  return 0; \
+} \
+\
+/** The n-th element from the oldest, n below name_count */ \
+static inline Type *name##_at(name *ring, uint32_t n) { \
+  return &ring->items[(ring->tail + n) & ((size) - 1)]; \
+}
+
+/*--------------------------------------Binary heap--------------------------------------
+ * Min-heap in an array (children of i at 2i+1 and 2i+2). Sifting moves a
+ * hole instead of swapping, one copy per level.
+ *
+ *   int lessFn(const Type *a, const Type *b);   (function or macro)
+ */
+#define HEAP_DEFINE(name, Type, capacity, lessFn) \
+typedef struct { \
+  uint32_t count; \
+  Type items[capacity]; \
+} name; \
+\
+static inline void name##_init(name *heap) { \
+  heap->count = 0; \
+} \
+\
+/** Returns 0, or -1 if the heap is full */ \
+static inline int name##_push(name *heap, const Type *item) { \
+  if (heap->count == (capacity)) \
+    return -1; \
+  uint32_t i = heap->count++; \
+  while (i > 0) { \
+    uint32_t parent = (i - 1) / 2; \
+    if (!lessFn(item, &heap->items[parent])) \
+      break; \
+    heap->items[i] = heap->items[parent]; \
+    i = parent; \
+  } \
+  heap->items[i] = *item; \
+  return 0; \
+} \
+\
+/** Smallest element, NULL if the heap is empty */ \
+static inline Type *name##_peek(name *heap) { \
+  return heap->count ? &heap->items[0] : NULL; \
+} \
+\
+/** Remove the smallest element into *item, returns 0, or -1 if the heap is empty */ \
+static inline int name##_pop(name *heap, Type *item) { \
+  if (!heap->count) \
+    return -1; \
+  *item = heap->items[0]; \
+  Type *last = &heap->items[--heap->count]; \
+  uint32_t i = 0; \
+  for (;;) { \
+    uint32_t child = 2 * i + 1; \
+    if (child >= heap->count) \
+      break; \
+    if (child + 1 < heap->count && lessFn(&heap->items[child + 1], &heap->items[child])) \
+      child++; \
+    if (!lessFn(&heap->items[child], last)) \
+      break; \
+    heap->items[i] = heap->items[child]; \
+    i = child; \
+  } \
+  heap->items[i] = *last; \
+  return 0; \
+}
+
+/*--------------------------------------Linked list--------------------------------------
+ * Circular and intrusive: the ListNode lives inside the element, the list
+ * head is a bare ListNode that points to itself when empty. container_of
+ * gets from a node back to its element.
+ */
+typedef struct ListNode {
+  struct ListNode *next;
+  struct ListNode *prev;
+} ListNode;
+
+// Static initializer for a list head
+#define LIST_HEAD_INIT(head) {&(head), &(head)}
+
+#define list_for_each(node, head) \
+  for (ListNode *node = (head)->next; node != (head); node = node->next)
+
+// Safe against removing node inside the loop
+#define list_for_each_safe(node, head) \
+  for (ListNode *node = (head)->next, *node##_next = node->next; node != (head); \
+       node = node##_next, node##_next = node->next)
+
+static inline void list_init(ListNode *head) {
+  head->next = head->prev = head;
+}
+
+static inline int list_empty(const ListNode *head) {
+  return head->next == head;
+}
+
+static inline void list_insert_between(ListNode *node, ListNode *prev, ListNode *next) {
+  node->prev = prev;
+  node->next = next;
+  prev->next = node;
+  next->prev = node;
+}
+
+/** Insert at the front */
+static inline void list_add(ListNode *head, ListNode *node) {
+  list_insert_between(node, head, head->next);
+}
+
+/** Insert at the back */
+static inline void list_add_tail(ListNode *head, ListNode *node) {
+  list_insert_between(node, head->prev, head);
+}
+
+/** Unlink node from whatever list it is on, node is left pointing to itself */
+static inline void list_remove(ListNode *node) {
+  node->prev->next = node->next;
+  node->next->prev = node->prev;
+  list_init(node);
+}
+
+#endif
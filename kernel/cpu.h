@@ -0,0 +1,51 @@
+#ifndef CPU_H
+#define CPU_H
+
+#define CPU_CORES       4
+#define CACHE_LINE_SIZE 64
+
+/**
+ * Index of the calling core (affinity level 0 of MPIDR)
+ */
+static inline unsigned int cpu_id() {
+  unsigned long mpidr;
+  asm volatile("mrs %0, mpidr_el1" : "=r"(mpidr));
+  return mpidr & 3;
+}
+
+/**
+ * Order memory accesses between cores (inner shareable)
+ */
+static inline void cpu_dmb() {
+  asm volatile("dmb ish" ::: "memory");
+}
+
+/**
+ * Bytes cleared by one DC ZVA, 0 when it can't be used: DCZID_EL0 prohibits
+ * it, or the MMU is off so all memory is Device, where DC ZVA faults
+ */
+static inline unsigned int cpu_zva_size() {
+  unsigned long el, sctlr, dczid;
+
+  asm volatile("mrs %0, CurrentEL" : "=r"(el));
+  if (((el >> 2) & 3) == 2)
+    asm volatile("mrs %0, sctlr_el2" : "=r"(sctlr));
+  else
+    asm volatile("mrs %0, sctlr_el1" : "=r"(sctlr));
+  asm volatile("mrs %0, dczid_el0" : "=r"(dczid));
+
+  if (!(sctlr & 1) || (dczid & 0x10))  // SCTLR.M, DCZID.DZP
+    return 0;
+  return 4 << (dczid & 0xF);           // DCZID.BS is log2 of the size in words
+}
+
+/**
+ * 1 if the core has the CRC32 instructions (ID_AA64ISAR0_EL1.CRC32)
+ */
+static inline int cpu_has_crc32() {
+  unsigned long isar0;
+  asm volatile("mrs %0, id_aa64isar0_el1" : "=r"(isar0));
+  return ((isar0 >> 16) & 0xF) != 0;
+}
+
+#endif
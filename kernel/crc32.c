@@ -0,0 +1,204 @@
+#include "crc32.h"
+#include "cpu.h"
+
+#if defined(__aarch64__)
+#include "../gcclib/arm_acle.h"
+#endif
+
+typedef struct {
+  uint32_t poly;
+  uint32_t table[8][256];     // slicing-by-8
+  uint32_t shift[2][4][256];  // times x^(8 * CRC_STREAM_BYTES) and x^(16 * CRC_STREAM_BYTES), per register byte
+} CrcModel;
+
+typedef uint64_t __attribute__((may_alias)) CrcWord;
+
+// Filled in by crc32_init, so the tables stay out of the image
+static CrcModel crcIeee;
+static CrcModel crcCastagnoli;
+static int crcHardware = 0;
+static int crcReady = 0;
+
+/**
+ * a * b mod poly, reflected (x^0 is the top bit), a nonzero. Multiplying a CRC
+ * register by x^(8n) gives the register after n more zero bytes, which is how
+ * two CRCs are combined.
+ */
+static uint32_t multmodp(uint32_t a, uint32_t b, uint32_t poly) {
+  uint32_t m = 1u << 31;
+  uint32_t p = 0;
+
+  for (;;) {
+    if (a & m) {
+      p ^= b;
+      if ((a & (m - 1)) == 0)
+        break;
+    }
+    m >>= 1;
+    b = (b & 1) ? (b >> 1) ^ poly : b >> 1;
+  }
+  return p;
+}
+
+// x^(8 * bytes) mod poly by square and multiply
+static uint32_t xpow8n(size_t bytes, uint32_t poly) {
+  uint32_t power = 1u << 23;    // x^8
+  uint32_t result = 1u << 31;   // x^0
+
+  while (bytes) {
+    if (bytes & 1)
+      result = multmodp(power, result, poly);
+    power = multmodp(power, power, poly);
+    bytes >>= 1;
+  }
+  return result;
+}
+
+static void model_init(CrcModel *model, uint32_t poly) {
+  model->poly = poly;
+  for (int i = 0; i < 256; i++) {
+    uint32_t c = i;
+    for (int k = 0; k < 8; k++)
+      c = (c & 1) ? (c >> 1) ^ model->poly : c >> 1;
+    model->table[0][i] = c;
+  }
+  for (int i = 0; i < 256; i++) {
+    for (int k = 1; k < 8; k++) {
+      uint32_t prev = model->table[k - 1][i];
+      model->table[k][i] = (prev >> 8) ^ model->table[0][prev & 0xFF];
+    }
+  }
+
+  // multiplying by a constant is linear in the register, one table per byte of it
+  for (int s = 0; s < 2; s++) {
+    uint32_t power = xpow8n((s + 1) * CRC_STREAM_BYTES, model->poly);
+    for (int k = 0; k < 4; k++) {
+      for (uint32_t i = 0; i < 256; i++)
+        model->shift[s][k][i] = multmodp(power, i << (8 * k), model->poly);
+    }
+  }
+}
+
+// crc advanced past one (s = 0) or two (s = 1) stream blocks of zeros
+static inline uint32_t crc_shift(const CrcModel *model, int s, uint32_t crc) {
+  const uint32_t (*t)[256] = model->shift[s];
+  return t[0][crc & 0xFF] ^ t[1][(crc >> 8) & 0xFF] ^ t[2][(crc >> 16) & 0xFF] ^ t[3][crc >> 24];
+}
+
+int crc32_init() {
+  if (!crcReady) {
+    model_init(&crcIeee, CRC32_POLY);
+    model_init(&crcCastagnoli, CRC32C_POLY);
+    crcHardware = cpu_has_crc32();
+    crcReady = 1;
+  }
+  return crcHardware;
+}
+
+int crc32_hw() {
+  return crc32_init();
+}
+
+// Register update over len bytes, no pre or post inversion
+static uint32_t crc_update_table(const CrcModel *model, uint32_t crc, const uint8_t *p, size_t len) {
+  const uint32_t (*t)[256] = model->table;
+
+  // byte steps until the words are aligned, the MMU is off so they must be
+  for (; len && ((uintptr_t)p & 7); len--)
+    crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+
+  for (; len >= 8; len -= 8, p += 8) {
+    uint64_t w = *(const CrcWord *)p ^ crc;
+    crc = t[7][w & 0xFF] ^ t[6][(w >> 8) & 0xFF] ^ t[5][(w >> 16) & 0xFF] ^ t[4][(w >> 24) & 0xFF] ^
+          t[3][(w >> 32) & 0xFF] ^ t[2][(w >> 40) & 0xFF] ^ t[1][(w >> 48) & 0xFF] ^ t[0][w >> 56];
+  }
+
+  while (len--)
+    crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+  return crc;
+}
+
+#if defined(__aarch64__)
+/**
+ * Register update with crc32x/crc32cx. Each instruction depends on the last,
+ * so one stream waits out the latency every word. Three streams over
+ * adjacent blocks keep the unit busy; the first two are then advanced past
+ * the blocks after them with the shift tables and the results XORed.
+ */
+__attribute__((target("+crc")))
+static uint32_t crc_update_hw(const CrcModel *model, uint32_t crc, const uint8_t *p, size_t len, int castagnoli) {
+#define CRC_BYTE(c, v) (castagnoli ? __crc32cb(c, v) : __crc32b(c, v))
+#define CRC_WORD(c, v) (castagnoli ? __crc32cd(c, v) : __crc32d(c, v))
+  for (; len && ((uintptr_t)p & 7); len--)
+    crc = CRC_BYTE(crc, *p++);
+
+  for (; len >= 3 * CRC_STREAM_BYTES; len -= 3 * CRC_STREAM_BYTES, p += 3 * CRC_STREAM_BYTES) {
+    const CrcWord *w0 = (const CrcWord *)p;
+    const CrcWord *w1 = (const CrcWord *)(p + CRC_STREAM_BYTES);
+    const CrcWord *w2 = (const CrcWord *)(p + 2 * CRC_STREAM_BYTES);
+    uint32_t crc1 = 0, crc2 = 0;
+
+    for (int i = 0; i < CRC_STREAM_BYTES / 8; i++) {
+      crc = CRC_WORD(crc, w0[i]);
+      crc1 = CRC_WORD(crc1, w1[i]);
+      crc2 = CRC_WORD(crc2, w2[i]);
+    }
+    crc = crc_shift(model, 1, crc) ^ crc_shift(model, 0, crc1) ^ crc2;
+  }
+
+  for (; len >= 8; len -= 8, p += 8)
+    crc = CRC_WORD(crc, *(const CrcWord *)p);
+
+  while (len--)
+    crc = CRC_BYTE(crc, *p++);
+  return crc;
+#undef CRC_BYTE
+#undef CRC_WORD
+}
+#endif
+
+uint32_t crc32(uint32_t crc, const void *data, size_t len) {
+  crc32_init();
+#if defined(__aarch64__)
+  if (crcHardware)
+    return ~crc_update_hw(&crcIeee, ~crc, data, len, 0);
+#endif
+  return ~crc_update_table(&crcIeee, ~crc, data, len);
+}
+
+uint32_t crc32c(uint32_t crc, const void *data, size_t len) {
+  crc32_init();
+#if defined(__aarch64__)
+  if (crcHardware)
+    return ~crc_update_hw(&crcCastagnoli, ~crc, data, len, 1);
+#endif
+  return ~crc_update_table(&crcCastagnoli, ~crc, data, len);
+}
+
+uint32_t crc32_table(uint32_t crc, const void *data, size_t len) {
+  crc32_init();
+  return ~crc_update_table(&crcIeee, ~crc, data, len);
+}
+
+uint32_t crc32c_table(uint32_t crc, const void *data, size_t len) {
+  crc32_init();
+  return ~crc_update_table(&crcCastagnoli, ~crc, data, len);
+}
+
+/**
+ * CRC of two pieces one after the other, from crc1 of the first, crc2 of the
+ * second and the second's length, like zlib's crc32_combine
+ */
+static uint32_t crc_combine(const CrcModel *model, uint32_t crc1, uint32_t crc2, size_t len2) {
+  return multmodp(xpow8n(len2, model->poly), crc1, model->poly) ^ crc2;
+}
+
+uint32_t crc32_combine(uint32_t crc1, uint32_t crc2, size_t len2) {
+  crc32_init();
+  return crc_combine(&crcIeee, crc1, crc2, len2);
+}
+
+uint32_t crc32c_combine(uint32_t crc1, uint32_t crc2, size_t len2) {
+  crc32_init();
+  return crc_combine(&crcCastagnoli, crc1, crc2, len2);
+}
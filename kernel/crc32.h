@@ -0,0 +1,36 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include "../gcclib/stddef.h"
+#include "../gcclib/stdint.h"
+
+/*
+ * CRC-32 (IEEE 802.3, zlib/PNG/Ethernet) and CRC-32C (Castagnoli, iSCSI/ext4)
+ * Uses the ARMv8 CRC32 instructions when ID_AA64ISAR0_EL1 reports them, with
+ * three independent streams so the instruction latency overlaps, and a
+ * slicing-by-8 table otherwise. Same calling convention as zlib: start with
+ * 0, pass the previous result to continue over the next piece.
+ */
+
+#define CRC32_POLY   0xEDB88320   // reflected
+#define CRC32C_POLY  0x82F63B78
+
+// Bytes each of the three streams covers per step
+#define CRC_STREAM_BYTES 1024
+
+// Build the tables, returns 1 if the instructions are used
+int crc32_init();
+int crc32_hw();
+
+uint32_t crc32(uint32_t crc, const void *data, size_t len);
+uint32_t crc32c(uint32_t crc, const void *data, size_t len);
+
+// CRC of a piece followed by another of len2 bytes, from the CRC of each
+uint32_t crc32_combine(uint32_t crc1, uint32_t crc2, size_t len2);
+uint32_t crc32c_combine(uint32_t crc1, uint32_t crc2, size_t len2);
+
+// Table-only versions, the reference for the instruction path
+uint32_t crc32_table(uint32_t crc, const void *data, size_t len);
+uint32_t crc32c_table(uint32_t crc, const void *data, size_t len);
+
+#endif
@@ -0,0 +1,222 @@
+#include "dlog.h"
+#include "timer.h"
+#include "lock.h"
+#include "../uart/uart.h"
+
+DlogStats dlogStats;
+
+static uint8_t dlogRing[DLOG_RING_SIZE];
+static volatile unsigned int dlogHead = 0;  // written by dlog_write()
+static volatile unsigned int dlogTail = 0;  // written by dlog_flush()
+static unsigned long lastTimestamp = 0;
+static CoreLock dlogLock;                   // held by dlog_write()
+
+// LEB128 style varint, returns the new position or 0 if it doesn't fit
+static size_t put_varint(uint8_t *buffer, size_t pos, size_t size, uint64_t value) {
+  do {
+    if (pos >= size)
+      return 0;
+    uint8_t byte = value & 0x7F;
+    value >>= 7;
+    buffer[pos++] = byte | (value ? 0x80 : 0);
+  } while (value);
+  return pos;
+}
+
+// Signed values zigzag mapped first, so small negative numbers stay short
+static size_t put_zigzag(uint8_t *buffer, size_t pos, size_t size, int64_t value) {
+  return put_varint(buffer, pos, size, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+// Raw bytes in memory order (little-endian), returns the new position or 0 if they don't fit
+static size_t put_bytes(uint8_t *buffer, size_t pos, size_t size, const void *value, size_t len) {
+  const uint8_t *bytes = value;
+
+  if (pos + len > size)
+    return 0;
+  for (size_t i = 0; i < len; i++)
+    buffer[pos++] = bytes[i];
+  return pos;
+}
+
+/**
+ * Encode one record, walking the format string only to find the argument types.
+ * Returns the record length, 0 if it doesn't fit in the buffer.
+ */
+size_t dlog_encode(uint8_t *buffer, size_t size, uint32_t id, unsigned long delta, const char *fmt, va_list args) {
+  va_list ap;
+  size_t pos = 0;
+
+  if (size == 0)
+    return 0;
+  buffer[pos++] = DLOG_SYNC;
+  if (!(pos = put_varint(buffer, pos, size, id)) || !(pos = put_varint(buffer, pos, size, delta)))
+    return 0;
+
+  va_copy(ap, args);
+  while (*fmt) {
+    if (*fmt++ != '%')
+      continue;
+
+    // flags, width and precision only matter to the decoder, but a '*' width
+    // or precision takes an int argument, queued ahead of the value
+    while (*fmt == '-' || *fmt == '+' || *fmt == ' ' || *fmt == '#' || *fmt == '0')
+      fmt++;
+    if (*fmt == '*') {
+      pos = put_zigzag(buffer, pos, size, va_arg(ap, int));
+      fmt++;
+    }
+    while (*fmt >= '0' && *fmt <= '9')
+      fmt++;
+    if (*fmt == '.') {
+      fmt++;
+      if (*fmt == '*' && pos) {
+        pos = put_zigzag(buffer, pos, size, va_arg(ap, int));
+        fmt++;
+      }
+      while (*fmt >= '0' && *fmt <= '9')
+        fmt++;
+    }
+    if (!pos)
+      break;
+
+    int isLong = 0, isLongDouble = 0;
+    for (;; fmt++) {
+      if (*fmt == 'l' || *fmt == 'z' || *fmt == 'j' || *fmt == 't' || *fmt == 'q')
+        isLong = 1;
+      else if (*fmt == 'L')
+        isLongDouble = 1;
+      else if (*fmt != 'h')
+        break;
+    }
+
+    switch (*fmt++) {
+    case 'd':
+    case 'i':
+      pos = put_zigzag(buffer, pos, size, isLong ? va_arg(ap, long) : va_arg(ap, int));
+      break;
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+    case 'b':
+      pos = put_varint(buffer, pos, size, isLong ? va_arg(ap, unsigned long) : va_arg(ap, unsigned int));
+      break;
+    case 'p':
+      pos = put_varint(buffer, pos, size, (uintptr_t)va_arg(ap, void *));
+      break;
+    case 'n':
+      (void)va_arg(ap, void *);
+      break;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+      if (isLongDouble) {
+        long double v = va_arg(ap, long double);
+        pos = put_bytes(buffer, pos, size, &v, sizeof(v));
+      }
+      else {
+        double v = va_arg(ap, double);
+        pos = put_bytes(buffer, pos, size, &v, sizeof(v));
+      }
+      break;
+    case 'c':
+      if (pos < size)
+        buffer[pos++] = (uint8_t)va_arg(ap, int);
+      else
+        pos = 0;
+      break;
+    case 's': {
+      const char *s = va_arg(ap, const char *);
+      size_t len = 0;
+      if (!s)
+        s = "(null)";
+      while (s[len] && len < DLOG_MAX_STRING)
+        len++;
+      pos = put_varint(buffer, pos, size, len);
+      if (pos && pos + len <= size) {
+        for (size_t i = 0; i < len; i++)
+          buffer[pos++] = s[i];
+      }
+      else {
+        pos = 0;
+      }
+      break;
+    }
+    case '\0':
+      fmt--;
+      break;
+    default:
+      // %% and unknown conversions carry no argument
+      break;
+    }
+
+    if (!pos)
+      break;
+  }
+  va_end(ap);
+  return pos;
+}
+
+/**
+ * Queue a record, drops it if the ring is full. Any core may log: the lock
+ * keeps records whole and their timestamp deltas in ring order.
+ */
+void dlog_write(uint32_t id, const char *fmt, ...) {
+  uint8_t record[DLOG_MAX_RECORD];
+  va_list ap;
+
+  lock_acquire(&dlogLock);
+  unsigned long now = timer_ticks();
+  va_start(ap, fmt);
+  size_t len = dlog_encode(record, sizeof(record), id, now - lastTimestamp, fmt, ap);
+  va_end(ap);
+
+  if (!len || DLOG_RING_SIZE - (dlogHead - dlogTail) < len) {
+    dlogStats.dropped++;
+    lock_release(&dlogLock);
+    return;
+  }
+
+  for (size_t i = 0; i < len; i++) {
+    dlogRing[(dlogHead + i) % DLOG_RING_SIZE] = record[i];
+  }
+  cpu_dmb();  // the bytes before the head that publishes them
+  dlogHead += len;
+  lastTimestamp = now;
+  dlogStats.records++;
+  dlogStats.bytes += len;
+  lock_release(&dlogLock);
+}
+
+size_t dlog_pending() {
+  return dlogHead - dlogTail;
+}
+
+/**
+ * Drain queued records to the log port as raw bytes, from the shell core only.
+ * Returns -1 without sending anything while the log port is the console:
+ * binary records there would land in the middle of the shell's text.
+ */
+int dlog_flush() {
+  int logPort = uart_log_port();
+
+  if (logPort == uart_console_port())
+    return -1;
+
+  const UartDriver *port = uartPorts[logPort];
+  unsigned int head = dlogHead;
+  cpu_dmb();
+
+  for (unsigned int tail = dlogTail; tail != head; tail++) {
+    port->sendc(dlogRing[tail % DLOG_RING_SIZE]);
+  }
+  cpu_dmb();  // done reading before writers may reuse the space
+  dlogTail = head;
+  return 0;
+}
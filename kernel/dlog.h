@@ -0,0 +1,59 @@
+#ifndef DLOG_H
+#define DLOG_H
+
+#include "../gcclib/stddef.h"
+#include "../gcclib/stdint.h"
+#include "../gcclib/stdarg.h"
+
+/*
+ * Deferred binary logging
+ * DLOG("fmt", args...) stores the format string in the .dlog section and only
+ * queues its offset (the ID) plus the raw arguments. The text is rebuilt on the
+ * host by tools/dlog_decode.py using build/dlog.bin, extracted from the ELF.
+ *
+ * Frame on the wire:
+ *   DLOG_SYNC, varint id, varint timestamp delta (timer ticks), arguments
+ * Arguments follow the conversions of the format string:
+ *   %d %i       zigzag varint
+ *   %u %x %X %o %b %p  varint
+ *   %c          one byte
+ *   %s          varint length + bytes (at most DLOG_MAX_STRING)
+ *   %f %e %g %a (any case)  the double's 8 bytes, little-endian;
+ *               with L the long double's 16 (IEEE quad on AArch64)
+ *   %n %%       nothing
+ * A '*' width or precision puts its int, as a zigzag varint, before the value.
+ * Flags and length modifiers (h, l, z, j, t) don't change the encoding.
+ */
+
+#define DLOG_SYNC        0xDF
+#define DLOG_RING_SIZE   4096   // must be a power of two
+#define DLOG_MAX_RECORD  128
+#define DLOG_MAX_STRING  32
+
+extern const char __dlog_start[];
+
+// Never called, lets the compiler check DLOG arguments against the format
+static inline __attribute__((format(__printf__, 1, 2))) void dlog_check(const char *fmt, ...) {
+  (void)fmt;
+}
+
+#define DLOG(fmt, ...) do { \
+    (0 ? dlog_check(fmt, ##__VA_ARGS__) : (void)0); \
+    static const char __dlog_fmt[] __attribute__((section(".dlog"), used)) = fmt; \
+    dlog_write((uint32_t)(__dlog_fmt - __dlog_start), __dlog_fmt, ##__VA_ARGS__); \
+  } while (0)
+
+typedef struct {
+  unsigned long records;
+  unsigned long bytes;    // encoded bytes queued
+  unsigned long dropped;  // records lost because the ring was full
+} DlogStats;
+
+extern DlogStats dlogStats;
+
+void dlog_write(uint32_t id, const char *fmt, ...);
+size_t dlog_encode(uint8_t *buffer, size_t size, uint32_t id, unsigned long delta, const char *fmt, va_list ap);
+size_t dlog_pending();
+int dlog_flush();
+
+#endif
@@ -0,0 +1,40 @@
+#include "gpio.h"
+
+/**
+ * Select the function (input, output or ALT0-5) of a GPIO pin
+ */
+void gpio_set_function(unsigned int pin, unsigned int func) {
+  volatile unsigned int *fsel = &GPFSEL0 + pin / 10;
+  unsigned int shift = (pin % 10) * 3;
+  unsigned int r = *fsel;
+
+  r &= ~(7 << shift);
+  r |= (func & 7) << shift;
+  *fsel = r;
+}
+
+/**
+ * Disable the pull up/down resistor of a GPIO pin
+ */
+void gpio_disable_pull(unsigned int pin) {
+  unsigned int r;
+
+#ifdef RPI3 //RPI3
+  volatile unsigned int *clk = pin < 32 ? &GPPUDCLK0 : &GPPUDCLK1;
+
+  GPPUD = 0;            //No pull up/down control
+  //Toogle clock to flush GPIO setup
+  r = 150; while(r--) { asm volatile("nop"); } //waiting 150 cycles
+  *clk = 1 << (pin % 32); //enable clock for the pin
+  r = 150; while(r--) { asm volatile("nop"); } //waiting 150 cycles
+  *clk = 0;             // flush GPIO setup
+
+#else //RPI4
+  volatile unsigned int *ctrl = &GPIO_PUP_PDN_CNTRL_REG0 + pin / 16;
+  unsigned int shift = (pin % 16) * 2;
+
+  r = *ctrl;
+  r &= ~(3 << shift); //No resistor is selected
+  *ctrl = r;
+#endif
+}
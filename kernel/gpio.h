@@ -43,4 +43,17 @@
 typedef unsigned char uint8_t;
 typedef unsigned short int uint16_t;
 typedef unsigned int uint32_t;
-typedef unsigned long int uint64_t;
\ No newline at end of file
+typedef unsigned long int uint64_t;
+
+//GPIO function select values
+#define GPIO_FUNC_INPUT  0b000
+#define GPIO_FUNC_OUTPUT 0b001
+#define GPIO_FUNC_ALT0   0b100
+#define GPIO_FUNC_ALT1   0b101
+#define GPIO_FUNC_ALT2   0b110
+#define GPIO_FUNC_ALT3   0b111
+#define GPIO_FUNC_ALT4   0b011
+#define GPIO_FUNC_ALT5   0b010
+
+void gpio_set_function(unsigned int pin, unsigned int func);
+void gpio_disable_pull(unsigned int pin);
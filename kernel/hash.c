@@ -0,0 +1,101 @@
+#include "hash.h"
+#include "string.h"
+
+typedef uint64_t __attribute__((may_alias)) HashWord;
+
+// Whole aligned words are read around the key, which ASan reports as overflows
+#if defined(__SANITIZE_ADDRESS__)
+#define ALIGNED_OVERREAD __attribute__((no_sanitize_address))
+#else
+#define ALIGNED_OVERREAD
+#endif
+
+/*
+ * Loads at any alignment without unaligned accesses (the MMU is off): the
+ * aligned words around the bytes are loaded and shifted together. They never
+ * reach past the aligned word holding the last byte, so never into another
+ * page.
+ */
+ALIGNED_OVERREAD
+static inline uint64_t read64(const uint8_t *p) {
+  unsigned int shift = ((uintptr_t)p & 7) * 8;
+  const HashWord *w = (const HashWord *)((uintptr_t)p & ~(uintptr_t)7);
+
+  if (!shift)
+    return w[0];
+  return (w[0] >> shift) | (w[1] << (64 - shift));
+}
+
+ALIGNED_OVERREAD
+static inline uint64_t read32(const uint8_t *p) {
+  // the 4 bytes may straddle two words, read64 never reaches past p + 7's word
+  unsigned int offset = (uintptr_t)p & 7;
+  if (offset <= 4) {
+    const HashWord *w = (const HashWord *)((uintptr_t)p & ~(uintptr_t)7);
+    return (uint32_t)(*w >> (offset * 8));
+  }
+  return (uint32_t)read64(p);
+}
+
+// 1 to 3 bytes: first, middle and last, every byte counted
+static inline uint64_t read_small(const uint8_t *p, size_t len) {
+  return ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+}
+
+uint64_t hash_bytes(const void *data, size_t len, uint64_t seed) {
+  const uint8_t *p = data;
+  uint64_t a, b;
+
+  seed ^= hash_mix(seed ^ HASH_SECRET0, HASH_SECRET1);
+
+  if (len <= 16) {
+    if (len >= 4) {
+      // two overlapping 4-byte reads from each end cover 4..16 bytes
+      size_t mid = (len >> 3) << 2;
+      a = (read32(p) << 32) | read32(p + mid);
+      b = (read32(p + len - 4) << 32) | read32(p + len - 4 - mid);
+    }
+    else if (len) {
+      a = read_small(p, len);
+      b = 0;
+    }
+    else {
+      a = b = 0;
+    }
+  }
+  else {
+    size_t left = len;
+
+    if (left > 48) {
+      // three independent lanes so the multiplies overlap
+      uint64_t seed1 = seed, seed2 = seed;
+      do {
+        seed = hash_mix(read64(p) ^ HASH_SECRET1, read64(p + 8) ^ seed);
+        seed1 = hash_mix(read64(p + 16) ^ HASH_SECRET2, read64(p + 24) ^ seed1);
+        seed2 = hash_mix(read64(p + 32) ^ HASH_SECRET3, read64(p + 40) ^ seed2);
+        p += 48;
+        left -= 48;
+      } while (left > 48);
+      seed ^= seed1 ^ seed2;
+    }
+    while (left > 16) {
+      seed = hash_mix(read64(p) ^ HASH_SECRET1, read64(p + 8) ^ seed);
+      p += 16;
+      left -= 16;
+    }
+    // the last 16 bytes, overlapping what was already mixed
+    a = read64(p + left - 16);
+    b = read64(p + left - 8);
+  }
+
+  a ^= HASH_SECRET1;
+  b ^= seed;
+  unsigned __int128 r = (unsigned __int128)a * b;
+  a = (uint64_t)r;
+  b = (uint64_t)(r >> 64);
+  return hash_mix(a ^ HASH_SECRET0 ^ len, b ^ HASH_SECRET1);
+}
+
+uint64_t hash_str(const char *str) {
+  return hash_bytes(str, strlen(str), 0);
+}
@@ -0,0 +1,37 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include "../gcclib/stddef.h"
+#include "../gcclib/stdint.h"
+
+/*
+ * Non-cryptographic hashing for lookup tables (wyhash construction)
+ * Every step is a 64x64->128 bit multiply (mul + umulh) folded with XOR,
+ * so a short key costs a couple of multiplies and no loop. Fine for hash
+ * tables and caches; not for anything an attacker gets to choose keys for
+ * unless the seed is secret.
+ */
+
+// Mixing constants, odd with balanced bits
+#define HASH_SECRET0 0xa0761d6478bd642fUL
+#define HASH_SECRET1 0xe7037ed1a0b428dbUL
+#define HASH_SECRET2 0x8ebc6af09c88c6e3UL
+#define HASH_SECRET3 0x589965cc75374cc3UL
+
+// Multiply to 128 bits and fold the halves together
+static inline uint64_t hash_mix(uint64_t a, uint64_t b) {
+  unsigned __int128 r = (unsigned __int128)a * b;
+  return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+/**
+ * Hash of a 64-bit key, e.g. an address or an ID
+ */
+static inline uint64_t hash_u64(uint64_t key, uint64_t seed) {
+  return hash_mix(hash_mix(key ^ HASH_SECRET0, seed ^ HASH_SECRET1) ^ HASH_SECRET2, HASH_SECRET3);
+}
+
+uint64_t hash_bytes(const void *data, size_t len, uint64_t seed);
+uint64_t hash_str(const char *str);
+
+#endif
@@ -0,0 +1,163 @@
+#include "iocore.h"
+#include "smp.h"
+#include "console.h"
+#include "timer.h"
+
+// One deferred printf
+typedef struct {
+  const char *fmt;
+  int count;
+  FmtArg args[IOCORE_MAX_ARGS];
+  char strings[IOCORE_STRING_BYTES];
+} __attribute__((aligned(CACHE_LINE_SIZE))) IoRecord;
+
+// Records from one core, head and tail sit on their own cache lines
+typedef struct {
+  IoRecord slots[IOCORE_RING_SLOTS];
+  struct {
+    volatile unsigned long head;  // written by the producing core only
+    unsigned long queued;
+    unsigned long dropped;
+  } __attribute__((aligned(CACHE_LINE_SIZE))) producer;
+  struct {
+    volatile unsigned long tail;  // written by the I/O core only
+    unsigned long printed;
+  } __attribute__((aligned(CACHE_LINE_SIZE))) consumer;
+} IoRing;
+
+static IoRing rings[CPU_CORES];
+static volatile int ioRunning = 0;
+
+// Format every queued record, oldest first per core
+static int iocore_drain() {
+  int printed = 0;
+
+  for (int i = 0; i < CPU_CORES; i++) {
+    IoRing *ring = &rings[i];
+    unsigned long tail = ring->consumer.tail;
+
+    while (tail != ring->producer.head) {
+      // read the head before the record it publishes
+      cpu_dmb();
+      IoRecord *record = &ring->slots[tail & (IOCORE_RING_SLOTS - 1)];
+      printf_args(record->fmt, record->args, record->count);
+
+      // done with the record before handing the slot back
+      cpu_dmb();
+      ring->consumer.tail = ++tail;
+      ring->consumer.printed++;
+      printed++;
+    }
+  }
+  return printed;
+}
+
+static void iocore_main() {
+  while (1) {
+    iocore_drain();
+    // also moves the other cores' printf lines to the sinks
+    console_flush();
+  }
+}
+
+/**
+ * Hand the console to IOCORE_CORE and start formatting records there.
+ * Call from core 0, returns 0 if the core didn't come up.
+ */
+int iocore_start() {
+  if (ioRunning)
+    return 1;
+
+  console_flush();
+  console_set_owner(IOCORE_CORE);
+  if (!smp_start_core(IOCORE_CORE, iocore_main)) {
+    console_set_owner(cpu_id());
+    return 0;
+  }
+
+  unsigned long start = timer_ticks();
+  unsigned long wait = timer_freq() / 10;
+  while (!smp_core_online(IOCORE_CORE)) {
+    if (timer_ticks() - start >= wait) {
+      // no release stub answered, keep printing from this core
+      console_set_owner(cpu_id());
+      return 0;
+    }
+  }
+
+  ioRunning = 1;
+  return 1;
+}
+
+int iocore_running() {
+  return ioRunning;
+}
+
+/**
+ * Queue a printf for the I/O core, returns 1 if queued and 0 if dropped.
+ * Prints synchronously while the I/O core isn't running.
+ */
+int aprintf(const char *fmt, ...) {
+  va_list ap;
+
+  if (!ioRunning) {
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    return 1;
+  }
+
+  IoRing *ring = &rings[cpu_id()];
+  unsigned long head = ring->producer.head;
+
+  if (head - ring->consumer.tail == IOCORE_RING_SLOTS) {
+    ring->producer.dropped++;
+    return 0;
+  }
+
+  IoRecord *record = &ring->slots[head & (IOCORE_RING_SLOTS - 1)];
+  va_start(ap, fmt);
+  record->count = fmt_capture(fmt, ap, record->args, IOCORE_MAX_ARGS,
+                              record->strings, sizeof(record->strings));
+  va_end(ap);
+
+  if (record->count < 0) {
+    ring->producer.dropped++;
+    return 0;
+  }
+  record->fmt = fmt;
+
+  // the record must be complete before the I/O core can see the new head
+  cpu_dmb();
+  ring->producer.head = head + 1;
+  ring->producer.queued++;
+  return 1;
+}
+
+/**
+ * Wait until every queued record has been printed, 0 on timeout
+ */
+int iocore_wait_idle(unsigned int msec) {
+  unsigned long start = timer_ticks();
+  unsigned long wait = (timer_freq() * msec) / 1000;
+
+  for (int i = 0; i < CPU_CORES; i++) {
+    while (rings[i].consumer.tail != rings[i].producer.head) {
+      if (timer_ticks() - start >= wait)
+        return 0;
+    }
+  }
+  return 1;
+}
+
+void iocore_stats(IoCoreStats *stats) {
+  stats->queued = 0;
+  stats->dropped = 0;
+  stats->printed = 0;
+
+  for (int i = 0; i < CPU_CORES; i++) {
+    stats->queued += rings[i].producer.queued;
+    stats->dropped += rings[i].producer.dropped;
+    stats->printed += rings[i].consumer.printed;
+  }
+}
@@ -0,0 +1,37 @@
+#ifndef IOCORE_H
+#define IOCORE_H
+
+#include "cpu.h"
+#include "../cli/printf.h"
+
+/*
+ * I/O core
+ * aprintf() only saves the format pointer and its arguments into the calling
+ * core's record ring (single producer, single consumer). The I/O core takes
+ * the records, formats them and owns the console sinks, so the callers never
+ * pay for formatting or wait on the UART. Until the I/O core is started
+ * aprintf falls back to printf.
+ *
+ * The format must stay valid until printed (string literals are fine), %s
+ * arguments are copied. Records and printf lines from the same core may come
+ * out in either order.
+ */
+
+#define IOCORE_CORE         3      // core reserved for formatting and UART output
+#define IOCORE_RING_SLOTS   128    // records per core, power of two
+#define IOCORE_MAX_ARGS     8
+#define IOCORE_STRING_BYTES 48     // %s bytes per record, fills a 128 byte slot
+
+typedef struct {
+  unsigned long queued;
+  unsigned long dropped;   // ring full or too many arguments
+  unsigned long printed;
+} IoCoreStats;
+
+int iocore_start();
+int iocore_running();
+int aprintf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+int iocore_wait_idle(unsigned int msec);
+void iocore_stats(IoCoreStats *stats);
+
+#endif
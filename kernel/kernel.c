@@ -1,10 +1,46 @@
-#include "../uart/uart1.h"
+#include "../uart/uart.h"
 #include "../cli/printf.h"
 #include "../cli/cli.h"
+#include "timer.h"
+#include "console.h"
+#include "plog.h"
+#include "log.h"
+#include "crc32.h"
+#include "mbox.h"
+#include "page_alloc.h"
+#include "slab.h"
+
+extern char _end[];
+
+// Give the ARM memory above the kernel image to the page allocator. Everything
+// below _end stays out: the firmware stubs and spin table, the core stacks
+// below _start, and the image with its .bss and .noinit. Without an answer
+// from the firmware the allocator stays empty and kmalloc returns NULL.
+static void memory_init(){
+	unsigned int *response;
+	mbox_buffer_setup(ADDR(mBuf), MBOX_TAG_ARM_MEMORY, &response, 8, 0);
+	if (!mbox_call(ADDR(mBuf), MBOX_CH_PROP) || !(mBuf[4] & MBOX_TAG_RESPONSE) || !response[1]) {
+		LOG_WARN(LOG_MOD_KERNEL, "no ARM memory range from the firmware, page allocator not set up");
+		return;
+	}
+
+	uintptr_t start = response[0], end = (uintptr_t)response[0] + response[1]; // base, size
+	if (start < (uintptr_t)_end)
+		start = (uintptr_t)_end;
+	unsigned long pages = page_alloc_init(start, end);
+	LOG_INFO(LOG_MOD_KERNEL, "%lu free pages from 0x%lx to 0x%lx", pages, (unsigned long)start, (unsigned long)end);
+}
 
 void main(){
 	// set up serial console
 	uart_init();
+	int kept = plog_init();
+	console_init();
+	LOG_INFO(LOG_MOD_KERNEL, "boot %u, persistent log %s", plog_boot_count(), kept ? "kept" : "reset");
+	cycle_counter_init();
+	crc32_init();
+	memory_init();
+	slab_init();
 	initCli();
 
 	// run CLI
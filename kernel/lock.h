@@ -0,0 +1,53 @@
+#ifndef LOCK_H
+#define LOCK_H
+
+#include "cpu.h"
+
+/*
+ * Lamport's bakery lock for the CPU_CORES cores. It needs only ordered loads
+ * and stores, no exclusives, which aren't usable on the Device memory
+ * everything is while the MMU is off. A core takes a ticket one above every
+ * other core's and waits for the lower tickets (ties go to the lower core).
+ * Not reentrant, and not for interrupt handlers.
+ */
+typedef struct {
+  volatile unsigned int choosing[CPU_CORES];
+  volatile unsigned int ticket[CPU_CORES];  // 0 = not waiting or holding
+} CoreLock;
+
+static inline void lock_acquire(CoreLock *lock) {
+  unsigned int me = cpu_id(), max = 0;
+
+  lock->choosing[me] = 1;
+  cpu_dmb();
+  for (unsigned int i = 0; i < CPU_CORES; i++) {
+    if (lock->ticket[i] > max)
+      max = lock->ticket[i];
+  }
+  lock->ticket[me] = max + 1;
+  cpu_dmb();
+  lock->choosing[me] = 0;
+  cpu_dmb();
+
+  unsigned int mine = max + 1;
+  for (unsigned int i = 0; i < CPU_CORES; i++) {
+    if (i == me)
+      continue;
+    while (lock->choosing[i])
+      ;
+    cpu_dmb();
+    for (;;) {
+      unsigned int other = lock->ticket[i];
+      if (!other || other > mine || (other == mine && i > me))
+        break;
+    }
+  }
+  cpu_dmb();
+}
+
+static inline void lock_release(CoreLock *lock) {
+  cpu_dmb();
+  lock->ticket[cpu_id()] = 0;
+}
+
+#endif
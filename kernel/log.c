@@ -0,0 +1,22 @@
+#include "log.h"
+#include "../cli/printf.h"
+
+// All modules enabled at boot
+uint32_t logMask = (1u << LOG_MOD_COUNT) - 1;
+
+const char *logModuleNames[LOG_MOD_COUNT] = {"kernel", "cli", "mbox", "uart"};
+
+static const char *logLevelNames[] = {"DEBUG", "INFO", "WARN"};
+
+/**
+ * Print one log line prefixed with its level and module
+ */
+void log_printf(int level, int module, const char *fmt, ...) {
+  va_list ap;
+
+  PRINTF_FMT(LOG_PREFIX, logLevelNames[level], logModuleNames[module]);
+  va_start(ap, fmt);
+  vprintf(fmt, ap);
+  va_end(ap);
+  printf("\n");
+}
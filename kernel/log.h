@@ -0,0 +1,59 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include "../gcclib/stdint.h"
+
+/* Log levels, anything below LOG_LEVEL (set by the Makefile) compiles to nothing */
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_NONE  3
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+/* Module tags, one bit each in logMask */
+#define LOG_MOD_KERNEL 0
+#define LOG_MOD_CLI    1
+#define LOG_MOD_MBOX   2
+#define LOG_MOD_UART   3
+#define LOG_MOD_COUNT  4
+
+extern uint32_t logMask;
+extern const char *logModuleNames[LOG_MOD_COUNT];
+
+void log_printf(int level, int module, const char *fmt, ...)
+  __attribute__((format(__printf__, 3, 4)));
+
+/* Enabled levels cost one branch on the module mask */
+#define LOG_AT(level, module, fmt, ...) do { \
+    if (logMask & (1u << (module))) \
+      log_printf(level, module, fmt, ##__VA_ARGS__); \
+  } while (0)
+
+/* Disabled levels are still type checked but generate no code */
+#define LOG_NOTHING(level, module, fmt, ...) do { \
+    if (0) \
+      log_printf(level, module, fmt, ##__VA_ARGS__); \
+  } while (0)
+
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(module, fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, module, fmt, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(module, fmt, ...) LOG_NOTHING(LOG_LEVEL_DEBUG, module, fmt, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(module, fmt, ...) LOG_AT(LOG_LEVEL_INFO, module, fmt, ##__VA_ARGS__)
+#else
+#define LOG_INFO(module, fmt, ...) LOG_NOTHING(LOG_LEVEL_INFO, module, fmt, ##__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(module, fmt, ...) LOG_AT(LOG_LEVEL_WARN, module, fmt, ##__VA_ARGS__)
+#else
+#define LOG_WARN(module, fmt, ...) LOG_NOTHING(LOG_LEVEL_WARN, module, fmt, ##__VA_ARGS__)
+#endif
+
+#endif
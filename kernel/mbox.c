@@ -1,15 +1,13 @@
 #include "mbox.h"
 #include "gpio.h"
-#include "../uart/uart1.h"
-#include "../cli/printf.h"
+#include "../uart/uart.h"
+#include "log.h"
 #include "../gcclib/stddef.h"
 #include "../gcclib/stdint.h"
 #include "../gcclib/stdarg.h"
 
-volatile unsigned int mBuf[36];
-
-// Define mailbox buffer as per the alignment requirements
-volatile unsigned int __attribute__((aligned(16))) mbox_buffer[36];
+// The mailbox passes the buffer address in the upper 28 bits, so it must be 16-byte aligned
+volatile unsigned int __attribute__((aligned(16))) mBuf[36];
 
 // Function to read from the mailbox
 uint32_t mailbox_read(unsigned char channel) {
@@ -45,11 +43,11 @@ int mbox_call(unsigned int buffer_addr, unsigned char channel) {
   unsigned int msg = (buffer_addr & ~0xF) | (channel & 0xF);
   mailbox_send(msg, channel);
 
-  // Wait for the response
+  // Wait for the response, the firmware sets the buffer's response code
   if(msg == mailbox_read(channel)){
-    return mbox_buffer[1] == MBOX_RESPONSE;
+    return ((volatile unsigned int *)(uintptr_t)buffer_addr)[1] == MBOX_RESPONSE;
   }
-  uart_puts("Mailbox call failed\n");
+  LOG_WARN(LOG_MOD_MBOX, "Mailbox call failed");
   return 0;
 }
 
@@ -96,7 +94,7 @@ void mbox_buffer_setup(unsigned int buffer_addr, unsigned int tag_identifier, un
       break;
 
     default:
-      printf("Unknown tag identifier: %d\n", tag_identifier);
+      LOG_WARN(LOG_MOD_MBOX, "Unknown tag identifier: 0x%x", tag_identifier);
       va_end(args);
       return;
   }
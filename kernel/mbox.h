@@ -19,6 +19,8 @@ extern volatile unsigned int mBuf[36];
 // Request/Response code in Buffer content
 #define MBOX_RESPONSE 0x80000000
 #define MBOX_REQUEST 0
+// Set in a tag's request code once the firmware has answered it
+#define MBOX_TAG_RESPONSE 0x80000000
 
 // Status Value (from Status Register)
 #define MBOX_FULL 0x80000000
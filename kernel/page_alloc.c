@@ -0,0 +1,157 @@
+#include "page_alloc.h"
+#include "containers.h"
+#include "lock.h"
+#include "log.h"
+
+// Page bytes: the first page of a block holds its order and state, every other page 0
+#define PAGE_FREE   0x80
+#define PAGE_USED   0x40
+#define PAGE_ORDER  0x0F
+
+#define BLOCK_BYTES (PAGE_SIZE << PAGE_MAX_ORDER)
+
+static CoreLock pageLock;
+static uint8_t *pageState;          // one byte per page from pageBase
+static uintptr_t pageBase;          // start rounded down to BLOCK_BYTES, buddies pair up from here
+static unsigned long pageCount;     // pages from pageBase to end
+static ListNode freeLists[PAGE_ORDERS];
+static PageStats stats;
+
+static inline unsigned long page_index(uintptr_t addr) {
+  return (addr - pageBase) >> PAGE_SHIFT;
+}
+
+static inline ListNode *page_node(unsigned long page) {
+  return (ListNode *)(pageBase + (page << PAGE_SHIFT));
+}
+
+static void free_block_add(unsigned long page, unsigned int order) {
+  pageState[page] = PAGE_FREE | order;
+  list_add(&freeLists[order], page_node(page));
+  stats.freeBlocks[order]++;
+}
+
+static void free_block_remove(unsigned long page, unsigned int order) {
+  pageState[page] = 0;
+  list_remove(page_node(page));
+  stats.freeBlocks[order]--;
+}
+
+unsigned long page_alloc_init(uintptr_t start, uintptr_t end) {
+  start = (start + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+  end &= ~(PAGE_SIZE - 1);
+  if (end <= start)
+    return 0;
+
+  pageBase = start & ~(BLOCK_BYTES - 1);
+  pageCount = (end - pageBase) >> PAGE_SHIFT;
+  pageState = (uint8_t *)start;
+
+  // the page bytes take the first pages, everything below start stays reserved
+  start = (start + pageCount + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+  if (end <= start)
+    return 0;
+  for (unsigned long i = 0; i < pageCount; i++)
+    pageState[i] = 0;
+  for (unsigned int order = 0; order < PAGE_ORDERS; order++) {
+    list_init(&freeLists[order]);
+    stats.freeBlocks[order] = 0;
+  }
+
+  // hand out the range as the largest aligned blocks that fit
+  unsigned long page = page_index(start), last = page_index(end);
+  while (page < last) {
+    unsigned int order = PAGE_MAX_ORDER;
+    while ((page & ((1UL << order) - 1)) || page + (1UL << order) > last)
+      order--;
+    free_block_add(page, order);
+    page += 1UL << order;
+  }
+
+  stats.start = start;
+  stats.end = end;
+  stats.totalPages = stats.freePages = page_index(end) - page_index(start);
+  stats.allocs = stats.failures = 0;
+  return stats.totalPages;
+}
+
+void *page_alloc(unsigned int order) {
+  if (order > PAGE_MAX_ORDER || !pageState)
+    return NULL;
+
+  lock_acquire(&pageLock);
+
+  unsigned int found = order;
+  while (found < PAGE_ORDERS && list_empty(&freeLists[found]))
+    found++;
+  if (found == PAGE_ORDERS) {
+    stats.failures++;
+    lock_release(&pageLock);
+    return NULL;
+  }
+
+  unsigned long page = page_index((uintptr_t)freeLists[found].next);
+  free_block_remove(page, found);
+
+  // split down to the order asked for, the upper halves go back as free blocks
+  while (found > order) {
+    found--;
+    free_block_add(page + (1UL << found), found);
+  }
+  pageState[page] = PAGE_USED | order;
+  stats.freePages -= 1UL << order;
+  stats.allocs++;
+
+  lock_release(&pageLock);
+  return (void *)(pageBase + (page << PAGE_SHIFT));
+}
+
+void page_free(void *block) {
+  uintptr_t addr = (uintptr_t)block;
+
+  if (!pageState || addr < stats.start || addr >= stats.end || (addr & (PAGE_SIZE - 1))) {
+    LOG_WARN(LOG_MOD_KERNEL, "page_free: %p is not a managed page", block);
+    return;
+  }
+
+  lock_acquire(&pageLock);
+
+  unsigned long page = page_index(addr);
+  if (!(pageState[page] & PAGE_USED)) {
+    lock_release(&pageLock);
+    LOG_WARN(LOG_MOD_KERNEL, "page_free: %p is not an allocated block", block);
+    return;
+  }
+
+  unsigned int order = pageState[page] & PAGE_ORDER;
+  stats.freePages += 1UL << order;
+  pageState[page] = 0;
+
+  // merge with the buddy while it is a whole free block of the same order
+  while (order < PAGE_MAX_ORDER) {
+    unsigned long buddy = page ^ (1UL << order);
+    if (buddy >= pageCount || pageState[buddy] != (PAGE_FREE | order))
+      break;
+    free_block_remove(buddy, order);
+    page &= ~(1UL << order);
+    order++;
+  }
+  free_block_add(page, order);
+
+  lock_release(&pageLock);
+}
+
+int page_order(const void *addr) {
+  uintptr_t a = (uintptr_t)addr;
+
+  if (!pageState || a < stats.start || a >= stats.end || (a & (PAGE_SIZE - 1)))
+    return -1;
+  uint8_t state = pageState[page_index(a)];
+  return (state & PAGE_USED) ? (int)(state & PAGE_ORDER) : -1;
+}
+
+void page_alloc_stats(PageStats *out) {
+  lock_acquire(&pageLock);
+  *out = stats;
+  lock_release(&pageLock);
+}
@@ -0,0 +1,58 @@
+#ifndef PAGE_ALLOC_H
+#define PAGE_ALLOC_H
+
+#include "../gcclib/stddef.h"
+#include "../gcclib/stdint.h"
+
+/*
+ * Buddy page allocator: blocks of 2^order pages, 4KB (order 0) to 2MB
+ * (order 9), aligned to their size. A split block's halves are buddies
+ * (their addresses differ in one bit) and merge again once both are free,
+ * so alloc and free walk at most PAGE_ORDERS levels.
+ *
+ * Free blocks are kept on one list per order, linked through their first
+ * bytes. One byte per page outside them records which pages start a block,
+ * its order and whether it is free, placed at the start of the managed range.
+ * Callable from any core, not from interrupt handlers.
+ */
+
+#define PAGE_SHIFT      12
+#define PAGE_SIZE       (1UL << PAGE_SHIFT)
+#define PAGE_MAX_ORDER  9                     // 2MB
+#define PAGE_ORDERS     (PAGE_MAX_ORDER + 1)
+
+typedef struct {
+  uintptr_t start;                     // first managed page, after the page bytes
+  uintptr_t end;
+  unsigned long totalPages;            // managed pages
+  unsigned long freePages;
+  unsigned long freeBlocks[PAGE_ORDERS];
+  unsigned long allocs;                // successful page_alloc calls
+  unsigned long failures;              // page_alloc calls with nothing large enough
+} PageStats;
+
+/**
+ * Manage the memory from start to end (page aligned inward), returns the
+ * number of pages handed out to the free lists
+ */
+unsigned long page_alloc_init(uintptr_t start, uintptr_t end);
+
+/**
+ * A free block of 2^order pages, NULL if none is left or order > PAGE_MAX_ORDER
+ */
+void *page_alloc(unsigned int order);
+
+/**
+ * Return a block from page_alloc, its order is remembered. Anything else
+ * is logged and ignored.
+ */
+void page_free(void *block);
+
+/**
+ * Order of the allocated block starting at addr, -1 if there is none
+ */
+int page_order(const void *addr);
+
+void page_alloc_stats(PageStats *stats);
+
+#endif
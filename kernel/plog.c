@@ -0,0 +1,104 @@
+#include "plog.h"
+#include "../cli/printf.h"
+
+static PlogRing plog __attribute__((section(".noinit")));
+
+static uint32_t header_sum() {
+  uint32_t words[] = {plog.magic, plog.bootCount, (uint32_t)plog.head,
+                      (uint32_t)(plog.head >> 32), plog.dataSum};
+  uint32_t sum = 0;
+
+  for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+    sum = ((sum << 5) | (sum >> 27)) ^ words[i];
+  }
+  return ~sum;
+}
+
+static uint32_t data_sum() {
+  uint32_t sum = 0;
+  for (size_t i = 0; i < PLOG_SIZE; i++) {
+    sum += (unsigned char)plog.data[i];
+  }
+  return sum;
+}
+
+static void plog_reset(uint32_t bootCount) {
+  for (size_t i = 0; i < PLOG_SIZE; i++) {
+    plog.data[i] = 0;
+  }
+  plog.magic = PLOG_MAGIC;
+  plog.bootCount = bootCount;
+  plog.head = 0;
+  plog.dataSum = 0;
+  plog.headerSum = header_sum();
+}
+
+/**
+ * Validate the ring left by the previous boot, keep it and bump the boot count,
+ * or start a fresh one. Either way a boot marker line is appended.
+ */
+int plog_init() {
+  int valid = plog.magic == PLOG_MAGIC && plog.headerSum == header_sum() &&
+              plog.dataSum == data_sum();
+  char marker[32];
+
+  if (valid) {
+    plog.bootCount++;
+    plog.headerSum = header_sum();
+  }
+  else {
+    plog_reset(1);
+  }
+
+  plog_write(marker, snprintf(marker, sizeof(marker), "--- boot %u ---\n", plog.bootCount));
+  return valid;
+}
+
+uint32_t plog_boot_count() {
+  return plog.bootCount;
+}
+
+/**
+ * Append to the ring, used as a console sink
+ */
+void plog_write(const char *data, size_t len) {
+  uint64_t head = plog.head;
+  uint32_t sum = plog.dataSum;
+
+  while (len--) {
+    char *slot = &plog.data[head++ & (PLOG_SIZE - 1)];
+    sum += (unsigned char)*data - (unsigned char)*slot;
+    *slot = *data++;
+  }
+
+  plog.head = head;
+  plog.dataSum = sum;
+  plog.headerSum = header_sum();
+}
+
+/**
+ * Copy the oldest-first contents of the ring into out (NUL terminated),
+ * returns the number of bytes copied
+ */
+size_t plog_read(char *out, size_t size) {
+  if (!size)
+    return 0;
+
+  uint64_t count = plog.head < PLOG_SIZE ? plog.head : PLOG_SIZE;
+  if (count > size - 1)
+    count = size - 1;
+
+  uint64_t start = plog.head - count;
+  for (uint64_t i = 0; i < count; i++) {
+    out[i] = plog.data[(start + i) & (PLOG_SIZE - 1)];
+  }
+  out[count] = '\0';
+  return count;
+}
+
+/**
+ * Drop the stored text, the boot count is kept
+ */
+void plog_clear() {
+  plog_reset(plog.bootCount);
+}
@@ -0,0 +1,35 @@
+#ifndef PLOG_H
+#define PLOG_H
+
+#include "../gcclib/stddef.h"
+#include "../gcclib/stdint.h"
+
+/*
+ * Persistent log ring
+ * Lives in .noinit, which boot.S doesn't clear, so console output from the
+ * previous boot survives a warm reset or watchdog reset. The header checksum
+ * covers the write position and boot count. The data checksum is a byte sum,
+ * kept up to date as bytes are overwritten. A ring that fails either check
+ * (cold power-on, torn write) is cleared.
+ */
+
+#define PLOG_MAGIC  0x474F4C50   // "PLOG"
+#define PLOG_SIZE   16384        // must be a power of two
+
+typedef struct {
+  uint32_t magic;
+  uint32_t bootCount;
+  uint64_t head;        // total bytes ever written, head % PLOG_SIZE is the next slot
+  uint32_t dataSum;     // sum of every byte in data
+  uint32_t headerSum;   // checksum of the fields above
+  char data[PLOG_SIZE];
+} PlogRing;
+
+// 1 if the ring from the previous boot passed its checks, 0 if it was reset
+int plog_init();
+uint32_t plog_boot_count();
+void plog_write(const char *data, size_t len);
+size_t plog_read(char *out, size_t size);
+void plog_clear();
+
+#endif
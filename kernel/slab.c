@@ -0,0 +1,250 @@
+#include "slab.h"
+#include "containers.h"
+#include "lock.h"
+#include "log.h"
+
+#define SLAB_BYTES (PAGE_SIZE << SLAB_ORDER)
+
+typedef struct SlabCache SlabCache;
+
+// At the start of every slab, objects follow from cache->first
+typedef struct {
+  ListNode node;        // on the cache's partial or full list
+  SlabCache *cache;
+  void *free;           // free objects, linked through their first word
+  unsigned int inuse;
+} Slab;
+
+struct SlabCache {
+  CoreLock lock;
+  unsigned int size;
+  unsigned int first;   // offset of the first object in a slab
+  unsigned int perSlab;
+  ListNode partial;     // slabs with free objects
+  ListNode full;
+  unsigned long slabs;
+  unsigned long free;
+};
+
+typedef struct {
+  unsigned int count;
+  void *objects[SLAB_MAGAZINE];
+} Magazine;
+
+// Only ever written by its own core, a cache line apart from the others
+typedef struct {
+  Magazine magazines[SLAB_CLASSES];
+  unsigned long allocs[SLAB_CLASSES];
+  unsigned long frees[SLAB_CLASSES];
+  unsigned long largeAllocs;
+  unsigned long largeFrees;
+  long largePages;      // pages allocated minus pages freed on this core
+  unsigned long failures;
+} __attribute__((aligned(CACHE_LINE_SIZE))) CoreSlab;
+
+static SlabCache caches[SLAB_CLASSES];
+static CoreSlab cores[CPU_CORES];
+
+static inline unsigned int ceil_log2(unsigned long n) {
+  return n > 1 ? 64 - __builtin_clzl(n - 1) : 0;
+}
+
+static inline unsigned int size_class(size_t size) {
+  unsigned int shift = ceil_log2(size);
+  return shift > SLAB_MIN_SHIFT ? shift - SLAB_MIN_SHIFT : 0;
+}
+
+static inline Slab *slab_of(void *object) {
+  return (Slab *)((uintptr_t)object & ~(uintptr_t)(SLAB_BYTES - 1));
+}
+
+void slab_init() {
+  for (unsigned int i = 0; i < SLAB_CLASSES; i++) {
+    SlabCache *cache = &caches[i];
+    unsigned int align = SLAB_MIN_SIZE << i;
+    if (align > CACHE_LINE_SIZE)
+      align = CACHE_LINE_SIZE;
+
+    cache->size = SLAB_MIN_SIZE << i;
+    cache->first = (sizeof(Slab) + align - 1) & ~(align - 1);
+    cache->perSlab = (SLAB_BYTES - cache->first) / cache->size;
+    list_init(&cache->partial);
+    list_init(&cache->full);
+  }
+}
+
+// Add a slab to the partial list, 0 or -1 without memory. Cache lock held.
+static int cache_grow(SlabCache *cache) {
+  Slab *slab = page_alloc(SLAB_ORDER);
+  if (!slab)
+    return -1;
+
+  slab->cache = cache;
+  slab->inuse = 0;
+  slab->free = NULL;
+  // link the objects in address order, the first one ends up on top
+  for (unsigned int i = cache->perSlab; i-- > 0;) {
+    void **object = (void **)((uintptr_t)slab + cache->first + i * cache->size);
+    *object = slab->free;
+    slab->free = object;
+  }
+  list_add(&cache->partial, &slab->node);
+  cache->slabs++;
+  cache->free += cache->perSlab;
+  return 0;
+}
+
+// Move up to count free objects into out, returns how many
+static unsigned int cache_take(SlabCache *cache, void **out, unsigned int count) {
+  unsigned int taken = 0;
+
+  if (!cache->size)
+    return 0;  // before slab_init
+  lock_acquire(&cache->lock);
+  while (taken < count) {
+    if (list_empty(&cache->partial) && cache_grow(cache) < 0)
+      break;
+
+    Slab *slab = container_of(cache->partial.next, Slab, node);
+    while (taken < count && slab->free) {
+      void **object = slab->free;
+      slab->free = *object;
+      slab->inuse++;
+      out[taken++] = object;
+    }
+    if (!slab->free) {
+      list_remove(&slab->node);
+      list_add(&cache->full, &slab->node);
+    }
+  }
+  cache->free -= taken;
+  lock_release(&cache->lock);
+  return taken;
+}
+
+// Put objects back in their slabs, an emptied slab goes back to the page
+// allocator unless it is the cache's last partial one
+static void cache_give(SlabCache *cache, void **objects, unsigned int count) {
+  lock_acquire(&cache->lock);
+  for (unsigned int i = 0; i < count; i++) {
+    void **object = objects[i];
+    Slab *slab = slab_of(object);
+
+    if (!slab->free) {
+      list_remove(&slab->node);
+      list_add(&cache->partial, &slab->node);
+    }
+    *object = slab->free;
+    slab->free = object;
+    cache->free++;
+
+    if (--slab->inuse == 0 && cache->partial.next->next != &cache->partial) {
+      list_remove(&slab->node);
+      page_free(slab);
+      cache->slabs--;
+      cache->free -= cache->perSlab;
+    }
+  }
+  lock_release(&cache->lock);
+}
+
+static void *large_alloc(CoreSlab *core, size_t size) {
+  unsigned int order = ceil_log2((size + PAGE_SIZE - 1) >> PAGE_SHIFT);
+  void *block = order <= PAGE_MAX_ORDER ? page_alloc(order) : NULL;
+
+  if (!block) {
+    core->failures++;
+    return NULL;
+  }
+  core->largeAllocs++;
+  core->largePages += 1L << order;
+  return block;
+}
+
+void *kmalloc(size_t size) {
+  CoreSlab *core = &cores[cpu_id()];
+
+  if (!size)
+    return NULL;
+  if (size > SLAB_MAX_SIZE)
+    return large_alloc(core, size);
+
+  unsigned int class = size_class(size);
+  Magazine *mag = &core->magazines[class];
+  if (!mag->count) {
+    mag->count = cache_take(&caches[class], mag->objects, SLAB_MAGAZINE / 2);
+    if (!mag->count) {
+      core->failures++;
+      return NULL;
+    }
+  }
+  core->allocs[class]++;
+  return mag->objects[--mag->count];
+}
+
+void kfree(void *ptr) {
+  CoreSlab *core = &cores[cpu_id()];
+
+  if (!ptr)
+    return;
+
+  // whole page blocks start a block, slab objects never do (the header is there)
+  int order = page_order(ptr);
+  if (order >= 0) {
+    page_free(ptr);
+    core->largeFrees++;
+    core->largePages -= 1L << order;
+    return;
+  }
+
+  SlabCache *cache = slab_of(ptr)->cache;
+  if (cache < caches || cache >= caches + SLAB_CLASSES) {
+    LOG_WARN(LOG_MOD_KERNEL, "kfree: %p is not from kmalloc", ptr);
+    return;
+  }
+
+  unsigned int class = cache - caches;
+  Magazine *mag = &core->magazines[class];
+  if (mag->count == SLAB_MAGAZINE) {
+    // the older half goes back, the recently freed (cache-warm) half stays
+    cache_give(cache, mag->objects, SLAB_MAGAZINE / 2);
+    for (unsigned int i = 0; i < SLAB_MAGAZINE / 2; i++)
+      mag->objects[i] = mag->objects[i + SLAB_MAGAZINE / 2];
+    mag->count = SLAB_MAGAZINE / 2;
+  }
+  mag->objects[mag->count++] = ptr;
+  core->frees[class]++;
+}
+
+void slab_stats(SlabStats *stats) {
+  long largePages = 0;
+
+  stats->largeAllocs = stats->largeFrees = stats->failures = 0;
+  for (unsigned int i = 0; i < SLAB_CLASSES; i++) {
+    SlabCache *cache = &caches[i];
+    SlabClassStats *out = &stats->classes[i];
+
+    lock_acquire(&cache->lock);
+    out->size = cache->size;
+    out->slabs = cache->slabs;
+    out->objects = cache->slabs * cache->perSlab;
+    out->free = cache->free;
+    lock_release(&cache->lock);
+
+    // other cores' counters are read as they are, a snapshot is good enough
+    out->cached = out->allocs = out->frees = 0;
+    for (unsigned int c = 0; c < CPU_CORES; c++) {
+      out->cached += cores[c].magazines[i].count;
+      out->allocs += cores[c].allocs[i];
+      out->frees += cores[c].frees[i];
+    }
+  }
+  for (unsigned int c = 0; c < CPU_CORES; c++) {
+    stats->largeAllocs += cores[c].largeAllocs;
+    stats->largeFrees += cores[c].largeFrees;
+    stats->failures += cores[c].failures;
+    largePages += cores[c].largePages;
+  }
+  stats->largeBlocks = stats->largeAllocs - stats->largeFrees;
+  stats->largePages = largePages;
+}
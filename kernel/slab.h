@@ -0,0 +1,66 @@
+#ifndef SLAB_H
+#define SLAB_H
+
+#include "../gcclib/stddef.h"
+#include "page_alloc.h"
+
+/*
+ * Slab allocator and kmalloc on top of the page allocator.
+ *
+ * Requests up to SLAB_MAX_SIZE bytes round up to a power of two size class.
+ * Each class has a cache of 16KB slabs: a header, then equal objects, the
+ * free ones linked through their first word. Larger requests take whole
+ * page blocks.
+ *
+ * Each core keeps a magazine of free objects per class, so most kmalloc and
+ * kfree calls only touch the calling core's magazine and take no lock. An
+ * empty magazine is refilled from the class's slabs, a full one gives half
+ * back, under the cache lock. Not for interrupt handlers.
+ */
+
+#define SLAB_MIN_SHIFT   4                       // 16 bytes
+#define SLAB_MAX_SHIFT   11                      // 2KB
+#define SLAB_MIN_SIZE    (1UL << SLAB_MIN_SHIFT)
+#define SLAB_MAX_SIZE    (1UL << SLAB_MAX_SHIFT)
+#define SLAB_CLASSES     (SLAB_MAX_SHIFT - SLAB_MIN_SHIFT + 1)
+#define SLAB_ORDER       2                       // 16KB per slab
+#define SLAB_MAGAZINE    16                      // objects per core and class
+
+typedef struct {
+  unsigned long size;        // object size
+  unsigned long slabs;       // slabs held
+  unsigned long objects;     // object slots in them
+  unsigned long free;        // free slots in the slabs, magazines not counted
+  unsigned long cached;      // free objects waiting in the cores' magazines
+  unsigned long allocs;      // kmalloc calls served, all cores
+  unsigned long frees;
+} SlabClassStats;
+
+typedef struct {
+  SlabClassStats classes[SLAB_CLASSES];
+  unsigned long largeBlocks;   // live allocations above SLAB_MAX_SIZE
+  unsigned long largePages;
+  unsigned long largeAllocs;
+  unsigned long largeFrees;
+  unsigned long failures;      // kmalloc calls that returned NULL
+} SlabStats;
+
+/**
+ * Set up the caches, the page allocator must be running
+ */
+void slab_init();
+
+/**
+ * size bytes aligned to 16 (cache lines from 64 bytes up, pages above
+ * SLAB_MAX_SIZE), NULL for 0 or when memory runs out
+ */
+void *kmalloc(size_t size);
+
+/**
+ * Free memory from kmalloc, NULL is ignored
+ */
+void kfree(void *ptr);
+
+void slab_stats(SlabStats *stats);
+
+#endif
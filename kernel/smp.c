@@ -0,0 +1,49 @@
+#include "smp.h"
+#include "cpu.h"
+#include "../gcclib/stdint.h"
+
+extern char _start_secondary[];
+
+static volatile CoreEntry coreEntry[CPU_CORES];
+static volatile int coreOnline[CPU_CORES];
+
+/**
+ * Release a parked secondary core into entry. The firmware stub (or QEMU's)
+ * spins on the core's spin table slot and jumps to boot.S, which sets up the
+ * stack and calls secondary_main. Returns 0 if the core can't be started.
+ */
+int smp_start_core(unsigned int core, CoreEntry entry) {
+  if (core == 0 || core >= CPU_CORES || coreOnline[core])
+    return 0;
+
+  coreEntry[core] = entry;
+  cpu_dmb();
+
+  volatile uint64_t *spinTable = (volatile uint64_t *)SMP_SPIN_TABLE;
+  spinTable[core] = (uint64_t)(uintptr_t)_start_secondary;
+
+  // the stub waits in wfe, publish the address before waking it
+  asm volatile("dsb sy; sev" ::: "memory");
+  return 1;
+}
+
+int smp_core_online(unsigned int core) {
+  return core < CPU_CORES && coreOnline[core];
+}
+
+/**
+ * C entry of a secondary core, called from boot.S with its stack set up
+ */
+void secondary_main(unsigned int core) {
+  cpu_dmb();
+  CoreEntry entry = coreEntry[core];
+  coreOnline[core] = 1;
+
+  if (entry)
+    entry();
+
+  // entries aren't expected to return, park the core again
+  coreOnline[core] = 0;
+  while (1)
+    asm volatile("wfe");
+}
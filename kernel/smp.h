@@ -0,0 +1,18 @@
+#ifndef SMP_H
+#define SMP_H
+
+/* Shared with boot.S */
+#define SMP_SPIN_TABLE   0xd8       // release addresses of cores 0-3, 8 bytes each
+#define SMP_STACK_SIZE   0x10000    // per-core stack, core N's top is _start - N * SMP_STACK_SIZE
+
+#ifndef __ASSEMBLER__
+
+typedef void (*CoreEntry)(void);
+
+int smp_start_core(unsigned int core, CoreEntry entry);
+int smp_core_online(unsigned int core);
+void secondary_main(unsigned int core);
+
+#endif
+
+#endif
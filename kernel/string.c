@@ -1,6 +1,20 @@
 #include "string.h"
+#include "cpu.h"
 
-int strcmp(const char *str1, const char *str2)
+// Word and vector loads may run past either end of a buffer, but only within
+// the aligned 8 or 16 bytes holding its first or last byte, never into another
+// page. Tell AddressSanitizer so in host builds.
+#if defined(__SANITIZE_ADDRESS__)
+#define ALIGNED_OVERREAD __attribute__((no_sanitize_address))
+#else
+#define ALIGNED_OVERREAD
+#endif
+
+#if defined(__ARM_NEON)
+#include "../gcclib/arm_neon.h"
+#endif
+
+int strcmp_scalar(const char *str1, const char *str2)
 {
     while (*str1 && (*str1 == *str2))
     {
@@ -26,7 +40,7 @@ char *strcpy(char *dest, const char *src)
     return original_dest;
 }
 
-size_t strlen(const char *str)
+size_t strlen_scalar(const char *str)
 {
     const char *s = str;
 
@@ -38,45 +52,144 @@ size_t strlen(const char *str)
     return s - str;
 }
 
-char *strtok(char *str, const char *delim)
+char *strchr_scalar(const char *str, int c)
 {
-    static char *next_token = NULL;
-    if (str)
+    while (*str != (char)c)
     {
-        next_token = str;
+        if (!*str)
+        {
+            return NULL;
+        }
+        str++;
     }
+    return (char *)str;
+}
 
-    if (!next_token)
+unsigned long strtoul(const char *str, char **endptr, int base)
+{
+    unsigned long result = 0;
+
+    while (*str)
     {
-        return NULL;
+        unsigned int digit;
+
+        if (*str >= '0' && *str <= '9')
+        {
+            digit = *str - '0';
+        }
+        else if (*str >= 'A' && *str <= 'Z')
+        {
+            digit = *str - 'A' + 10;
+        }
+        else if (*str >= 'a' && *str <= 'z')
+        {
+            digit = *str - 'a' + 10;
+        }
+        else
+        {
+            break;
+        }
+
+        // "12x" in base 10 stops at the x rather than reading it as 33
+        if (digit >= (unsigned int)base)
+        {
+            break;
+        }
+        result = result * base + digit;
+        str++;
     }
 
-    char *start = next_token;
-    while (*next_token)
+    if (endptr)
     {
-        const char *d = delim;
-        while (*d)
+        *endptr = (char *)str;
+    }
+    return result;
+}
+
+// 1 if c is one of the delimiter characters
+static inline int is_delim(char c, const char *delim)
+{
+    while (*delim)
+    {
+        if (c == *delim++)
         {
-            if (*next_token == *d)
-            {
-                // Delimiter found
-                *next_token = '\0';
-                next_token++;
-                return start;
-            }
-            d++;
+            return 1;
         }
-        next_token++;
     }
+    return 0;
+}
+
+char *strtok_r(char *str, const char *delim, char **saveptr)
+{
+    char *s = str ? str : *saveptr;
 
-    if (start == next_token)
+    if (!s)
     {
         return NULL;
     }
-    return start;
+
+    // skip a run of delimiters, nothing left means no more tokens
+    while (*s && is_delim(*s, delim))
+    {
+        s++;
+    }
+    if (!*s)
+    {
+        *saveptr = s;
+        return NULL;
+    }
+
+    char *token = s;
+    while (*s && !is_delim(*s, delim))
+    {
+        s++;
+    }
+    if (*s)
+    {
+        *s++ = '\0';
+    }
+    *saveptr = s;
+    return token;
 }
 
-char *strstr(const char *haystack, const char *needle)
+char *strtok(char *str, const char *delim)
+{
+    static char *next_token = NULL;
+    return strtok_r(str, delim, &next_token);
+}
+
+int strsplit(char *str, const char *delim, char **argv, int max)
+{
+    int argc = 0;
+
+    for (;;)
+    {
+        while (*str && is_delim(*str, delim))
+        {
+            str++;
+        }
+        if (!*str)
+        {
+            return argc;
+        }
+        if (argc == max)
+        {
+            return -1;
+        }
+
+        argv[argc++] = str;
+        while (*str && !is_delim(*str, delim))
+        {
+            str++;
+        }
+        if (*str)
+        {
+            *str++ = '\0';
+        }
+    }
+}
+
+char *strstr_scalar(const char *haystack, const char *needle)
 {
     if (!*needle)
     {
@@ -108,3 +221,741 @@ char *strstr(const char *haystack, const char *needle)
 
     return NULL;
 }
+
+#if defined(__ARM_NEON)
+/*
+ * NEON versions: 16 bytes per step, always loaded from 16-byte aligned
+ * addresses. An aligned block never crosses a page, so reading the bytes
+ * before the string or past its terminator can't fault, and with the MMU
+ * off (Device memory) no access is ever unaligned.
+ */
+
+#define STRING_BLOCK 16
+
+// One bit nibble per byte of a 0x00/0xFF compare result, byte i at bits 4i..4i+3
+static inline uint64_t block_mask(uint8x16_t match)
+{
+    uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(match), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+}
+
+static inline const uint8_t *block_start(const char *p)
+{
+    return (const uint8_t *)((uintptr_t)p & ~(uintptr_t)(STRING_BLOCK - 1));
+}
+
+ALIGNED_OVERREAD size_t strlen(const char *str)
+{
+    const uint8_t *block = block_start(str);
+    unsigned int skip = (uintptr_t)str & (STRING_BLOCK - 1);
+
+    // first block: ignore the bytes in front of the string
+    uint64_t mask = block_mask(vceqzq_u8(vld1q_u8(block))) >> (skip * 4);
+    if (mask)
+    {
+        return __builtin_ctzll(mask) >> 2;
+    }
+
+    for (;;)
+    {
+        block += STRING_BLOCK;
+        mask = block_mask(vceqzq_u8(vld1q_u8(block)));
+        if (mask)
+        {
+            return (const char *)block - str + (__builtin_ctzll(mask) >> 2);
+        }
+    }
+}
+
+ALIGNED_OVERREAD char *strchr(const char *str, int c)
+{
+    const uint8_t *block = block_start(str);
+    unsigned int skip = (uintptr_t)str & (STRING_BLOCK - 1);
+    uint8x16_t wanted = vdupq_n_u8((uint8_t)c);
+    const char *found;
+
+    // stop on the character or the terminator, whichever comes first
+    uint8x16_t data = vld1q_u8(block);
+    uint64_t mask = block_mask(vorrq_u8(vceqq_u8(data, wanted), vceqzq_u8(data))) >> (skip * 4);
+    if (mask)
+    {
+        found = str + (__builtin_ctzll(mask) >> 2);
+    }
+    else
+    {
+        do
+        {
+            block += STRING_BLOCK;
+            data = vld1q_u8(block);
+            mask = block_mask(vorrq_u8(vceqq_u8(data, wanted), vceqzq_u8(data)));
+        } while (!mask);
+        found = (const char *)block + (__builtin_ctzll(mask) >> 2);
+    }
+
+    return *found == (char)c ? (char *)found : NULL;
+}
+
+ALIGNED_OVERREAD int strcmp(const char *str1, const char *str2)
+{
+    // blocks only line up when both strings sit at the same offset in a block
+    if (((uintptr_t)str1 ^ (uintptr_t)str2) & (STRING_BLOCK - 1))
+    {
+        return strcmp_scalar(str1, str2);
+    }
+
+    while ((uintptr_t)str1 & (STRING_BLOCK - 1))
+    {
+        if (!*str1 || *str1 != *str2)
+        {
+            return *(unsigned char *)str1 - *(unsigned char *)str2;
+        }
+        str1++;
+        str2++;
+    }
+
+    for (;;)
+    {
+        uint8x16_t a = vld1q_u8((const uint8_t *)str1);
+        uint8x16_t b = vld1q_u8((const uint8_t *)str2);
+
+        // first byte that differs or ends str1
+        uint64_t mask = block_mask(vorrq_u8(vmvnq_u8(vceqq_u8(a, b)), vceqzq_u8(a)));
+        if (mask)
+        {
+            unsigned int i = __builtin_ctzll(mask) >> 2;
+            return (unsigned char)str1[i] - (unsigned char)str2[i];
+        }
+        str1 += STRING_BLOCK;
+        str2 += STRING_BLOCK;
+    }
+}
+
+#else
+
+size_t strlen(const char *str)
+{
+    return strlen_scalar(str);
+}
+
+char *strchr(const char *str, int c)
+{
+    return strchr_scalar(str, c);
+}
+
+int strcmp(const char *str1, const char *str2)
+{
+    return strcmp_scalar(str1, str2);
+}
+
+#endif
+
+/*
+ * Memory functions. GCC emits calls to these for struct copies and
+ * initializers even with -ffreestanding. With the MMU off every access must
+ * be aligned to its size, so the wide loops only start once the destination
+ * is aligned; a source at another offset is read as aligned words and
+ * shifted into place.
+ */
+
+// Below this many bytes a byte loop is cheapest
+#define MEM_SMALL 16
+// From this many bytes, 64-byte blocks go through NEON registers or DC ZVA
+#define MEM_LARGE 256
+
+typedef uint64_t __attribute__((may_alias)) MemWord;
+
+// The 8 bytes starting shift bits into lo, continuing into hi (little endian)
+static inline uint64_t merge_words(uint64_t lo, uint64_t hi, unsigned int shift)
+{
+    return (lo >> shift) | (hi << (64 - shift));
+}
+
+ALIGNED_OVERREAD static void copy_forward(uint8_t *d, const uint8_t *s, size_t n)
+{
+    if (n >= MEM_SMALL)
+    {
+        while ((uintptr_t)d & 7)
+        {
+            *d++ = *s++;
+            n--;
+        }
+
+        unsigned int offset = (uintptr_t)s & 7;
+        if (offset == 0)
+        {
+#if defined(__ARM_NEON)
+            if (n >= MEM_LARGE && !(((uintptr_t)d ^ (uintptr_t)s) & 8))
+            {
+                if ((uintptr_t)d & 8)
+                {
+                    *(MemWord *)d = *(const MemWord *)s;
+                    d += 8;
+                    s += 8;
+                    n -= 8;
+                }
+                for (; n >= 64; n -= 64, d += 64, s += 64)
+                {
+                    uint8x16_t v0 = vld1q_u8(s), v1 = vld1q_u8(s + 16);
+                    uint8x16_t v2 = vld1q_u8(s + 32), v3 = vld1q_u8(s + 48);
+                    vst1q_u8(d, v0);
+                    vst1q_u8(d + 16, v1);
+                    vst1q_u8(d + 32, v2);
+                    vst1q_u8(d + 48, v3);
+                }
+            }
+#endif
+            // all loads before the stores, pairs become ldp/stp
+            for (; n >= 64; n -= 64, d += 64, s += 64)
+            {
+                const MemWord *ws = (const MemWord *)s;
+                uint64_t w0 = ws[0], w1 = ws[1], w2 = ws[2], w3 = ws[3];
+                uint64_t w4 = ws[4], w5 = ws[5], w6 = ws[6], w7 = ws[7];
+                MemWord *wd = (MemWord *)d;
+                wd[0] = w0;
+                wd[1] = w1;
+                wd[2] = w2;
+                wd[3] = w3;
+                wd[4] = w4;
+                wd[5] = w5;
+                wd[6] = w6;
+                wd[7] = w7;
+            }
+            for (; n >= 8; n -= 8, d += 8, s += 8)
+            {
+                *(MemWord *)d = *(const MemWord *)s;
+            }
+        }
+        else
+        {
+            // whole aligned words around the source never cross a page
+            unsigned int shift = offset * 8;
+            const MemWord *ws = (const MemWord *)(s - offset);
+            uint64_t lo = *ws++;
+            for (; n >= 8; n -= 8, d += 8)
+            {
+                uint64_t hi = *ws++;
+                *(MemWord *)d = merge_words(lo, hi, shift);
+                lo = hi;
+            }
+            s = (const uint8_t *)ws - 8 + offset;
+        }
+    }
+
+    while (n--)
+    {
+        *d++ = *s++;
+    }
+}
+
+// Same as copy_forward from the end down, for a destination above an overlapping source
+ALIGNED_OVERREAD static void copy_backward(uint8_t *d, const uint8_t *s, size_t n)
+{
+    d += n;
+    s += n;
+
+    if (n >= MEM_SMALL)
+    {
+        while ((uintptr_t)d & 7)
+        {
+            *--d = *--s;
+            n--;
+        }
+
+        unsigned int offset = (uintptr_t)s & 7;
+        if (offset == 0)
+        {
+            for (; n >= 64; n -= 64)
+            {
+                d -= 64;
+                s -= 64;
+                const MemWord *ws = (const MemWord *)s;
+                uint64_t w0 = ws[0], w1 = ws[1], w2 = ws[2], w3 = ws[3];
+                uint64_t w4 = ws[4], w5 = ws[5], w6 = ws[6], w7 = ws[7];
+                MemWord *wd = (MemWord *)d;
+                wd[7] = w7;
+                wd[6] = w6;
+                wd[5] = w5;
+                wd[4] = w4;
+                wd[3] = w3;
+                wd[2] = w2;
+                wd[1] = w1;
+                wd[0] = w0;
+            }
+            for (; n >= 8; n -= 8)
+            {
+                d -= 8;
+                s -= 8;
+                *(MemWord *)d = *(const MemWord *)s;
+            }
+        }
+        else
+        {
+            unsigned int shift = offset * 8;
+            const MemWord *ws = (const MemWord *)(s - offset);
+            uint64_t hi = *ws;
+            for (; n >= 8; n -= 8)
+            {
+                uint64_t lo = *--ws;
+                d -= 8;
+                *(MemWord *)d = merge_words(lo, hi, shift);
+                hi = lo;
+            }
+            s = (const uint8_t *)ws + offset;
+        }
+    }
+
+    while (n--)
+    {
+        *--d = *--s;
+    }
+}
+
+void *memcpy(void *dest, const void *src, size_t n)
+{
+    copy_forward(dest, src, n);
+    return dest;
+}
+
+void *memmove(void *dest, const void *src, size_t n)
+{
+    // unsigned: true when dest is below src or past its end
+    if ((uintptr_t)dest - (uintptr_t)src >= n)
+    {
+        copy_forward(dest, src, n);
+    }
+    else
+    {
+        copy_backward(dest, src, n);
+    }
+    return dest;
+}
+
+void *memset(void *dest, int c, size_t n)
+{
+    uint8_t *d = dest;
+    uint8_t byte = (uint8_t)c;
+
+    if (n >= MEM_SMALL)
+    {
+        uint64_t word = byte * 0x0101010101010101UL;
+
+        while ((uintptr_t)d & 7)
+        {
+            *d++ = byte;
+            n--;
+        }
+
+        if (byte == 0 && n >= MEM_LARGE)
+        {
+            unsigned int zva = cpu_zva_size();
+            if (zva && n >= 2 * zva)
+            {
+                // words up to a block boundary, then one DC ZVA per block
+                for (; (uintptr_t)d & (zva - 1); n -= 8, d += 8)
+                {
+                    *(MemWord *)d = 0;
+                }
+                for (; n >= zva; n -= zva, d += zva)
+                {
+                    asm volatile("dc zva, %0" : : "r"(d) : "memory");
+                }
+            }
+        }
+
+#if defined(__ARM_NEON)
+        if (n >= MEM_LARGE)
+        {
+            uint8x16_t v = vdupq_n_u8(byte);
+            if ((uintptr_t)d & 8)
+            {
+                *(MemWord *)d = word;
+                d += 8;
+                n -= 8;
+            }
+            for (; n >= 64; n -= 64, d += 64)
+            {
+                vst1q_u8(d, v);
+                vst1q_u8(d + 16, v);
+                vst1q_u8(d + 32, v);
+                vst1q_u8(d + 48, v);
+            }
+        }
+#endif
+
+        for (; n >= 64; n -= 64, d += 64)
+        {
+            MemWord *wd = (MemWord *)d;
+            wd[0] = word;
+            wd[1] = word;
+            wd[2] = word;
+            wd[3] = word;
+            wd[4] = word;
+            wd[5] = word;
+            wd[6] = word;
+            wd[7] = word;
+        }
+        for (; n >= 8; n -= 8, d += 8)
+        {
+            *(MemWord *)d = word;
+        }
+    }
+
+    while (n--)
+    {
+        *d++ = byte;
+    }
+    return dest;
+}
+
+int memcmp(const void *ptr1, const void *ptr2, size_t n)
+{
+    const uint8_t *a = ptr1;
+    const uint8_t *b = ptr2;
+
+    // words only when both sides can be aligned together
+    if (n >= MEM_SMALL && !(((uintptr_t)a ^ (uintptr_t)b) & 7))
+    {
+        for (; (uintptr_t)a & 7; n--, a++, b++)
+        {
+            if (*a != *b)
+            {
+                return *a - *b;
+            }
+        }
+        for (; n >= 8; n -= 8, a += 8, b += 8)
+        {
+            uint64_t x = *(const MemWord *)a;
+            uint64_t y = *(const MemWord *)b;
+            if (x != y)
+            {
+                // lowest differing byte is the first in memory
+                unsigned int shift = __builtin_ctzll(x ^ y) & ~7;
+                return (int)((x >> shift) & 0xFF) - (int)((y >> shift) & 0xFF);
+            }
+        }
+    }
+
+    for (; n; n--, a++, b++)
+    {
+        if (*a != *b)
+        {
+            return *a - *b;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Searching. memchr and strchr scan 16 bytes per step with NEON and handle
+ * one-byte needles; longer needles use Two-Way (Crochemore-Perrin), which
+ * is linear in the haystack whatever the input, with a Horspool skip on the
+ * window's last byte so most windows are passed without comparing at all.
+ */
+
+#if defined(__ARM_NEON)
+ALIGNED_OVERREAD void *memchr(const void *ptr, int c, size_t n)
+{
+    const uint8_t *s = ptr;
+    const uint8_t *end = s + n;
+
+    if (!n)
+    {
+        return NULL;
+    }
+
+    // aligned blocks, the last one may run past end but not past its page
+    const uint8_t *block = block_start(ptr);
+    const uint8_t *base = s;
+    uint8x16_t wanted = vdupq_n_u8((uint8_t)c);
+    uint64_t mask = block_mask(vceqq_u8(vld1q_u8(block), wanted)) >> (((uintptr_t)s & (STRING_BLOCK - 1)) * 4);
+
+    for (;;)
+    {
+        if (mask)
+        {
+            const uint8_t *found = base + (__builtin_ctzll(mask) >> 2);
+            return found < end ? (void *)found : NULL;
+        }
+
+        block += STRING_BLOCK;
+        if (block >= end)
+        {
+            return NULL;
+        }
+        base = block;
+        mask = block_mask(vceqq_u8(vld1q_u8(block), wanted));
+    }
+}
+#else
+ALIGNED_OVERREAD void *memchr(const void *ptr, int c, size_t n)
+{
+    const uint8_t *s = ptr;
+    uint8_t byte = (uint8_t)c;
+
+    if (n >= MEM_SMALL)
+    {
+        // eight bytes per step: a byte of x is zero where the haystack holds c
+        const uint64_t ones = 0x0101010101010101ULL;
+        for (; (uintptr_t)s & 7; n--, s++)
+        {
+            if (*s == byte)
+            {
+                return (void *)s;
+            }
+        }
+        for (; n >= 8; n -= 8, s += 8)
+        {
+            uint64_t x = *(const MemWord *)s ^ (ones * byte);
+            if ((x - ones) & ~x & (ones << 7))
+            {
+                break;
+            }
+        }
+    }
+
+    for (; n; n--, s++)
+    {
+        if (*s == byte)
+        {
+            return (void *)s;
+        }
+    }
+    return NULL;
+}
+#endif
+
+// The needle split at a critical factorization, and how far each window moves
+typedef struct
+{
+    size_t split;       // the right half starts here
+    size_t period;      // shift after the right half matched and the left didn't
+    size_t memory;      // bytes known to match after that shift, 0 unless periodic
+    uint8_t skip[256];  // distance from a byte's last place in the needle to its end, at most 255
+} SearchNeedle;
+
+// Start of the maximal suffix of n, under the byte order or its reverse, and its period
+static size_t search_max_suffix(const uint8_t *n, size_t nl, int reverse, size_t *period)
+{
+    size_t i = (size_t)-1, j = 0, k = 1, p = 1;
+
+    while (j + k < nl)
+    {
+        uint8_t a = n[i + k];
+        uint8_t b = n[j + k];
+        if (a == b)
+        {
+            if (k == p)
+            {
+                j += p;
+                k = 1;
+            }
+            else
+            {
+                k++;
+            }
+        }
+        else if ((a > b) != reverse)
+        {
+            j += k;
+            k = 1;
+            p = j - i;
+        }
+        else
+        {
+            i = j++;
+            k = p = 1;
+        }
+    }
+    *period = p;
+    return i + 1;
+}
+
+static void search_prepare(SearchNeedle *s, const uint8_t *n, size_t nl)
+{
+    size_t period, reversed;
+    size_t split = search_max_suffix(n, nl, 0, &period);
+    size_t split2 = search_max_suffix(n, nl, 1, &reversed);
+
+    // the later of the two splits is a critical factorization
+    if (split2 > split)
+    {
+        split = split2;
+        period = reversed;
+    }
+    s->split = split;
+
+    if (memcmp(n, n + period, split) == 0)
+    {
+        // periodic: after a period shift the first nl - period bytes still match
+        s->period = period;
+        s->memory = nl - period;
+    }
+    else
+    {
+        // not periodic, so split >= 1 and a shift by the longer half misses nothing
+        s->period = (split - 1 > nl - split ? split - 1 : nl - split) + 1;
+        s->memory = 0;
+    }
+
+    // a shorter skip than the real one is still safe
+    memset(s->skip, nl < 255 ? nl : 255, sizeof(s->skip));
+    for (size_t i = nl > 255 ? nl - 255 : 0; i < nl; i++)
+    {
+        s->skip[n[i]] = nl - 1 - i;
+    }
+}
+
+/*
+ * How far the window at h can move when its last byte doesn't match: the
+ * Horspool skip, then on to the next place the needle's last byte appears
+ * among the limit bytes after h[nl - 1]. Returns 0 if it appears nowhere.
+ */
+static size_t search_skip(const SearchNeedle *s, const uint8_t *h, const uint8_t *n, size_t nl, size_t limit, size_t memory)
+{
+    size_t k = s->skip[h[nl - 1]];
+
+    if (k <= limit)
+    {
+        const uint8_t *tail = memchr(h + nl - 1 + k, n[nl - 1], limit + 1 - k);
+        if (!tail)
+        {
+            return 0;
+        }
+        k = tail - (h + nl - 1);
+    }
+    // after a period shift, the matched prefix rules out anything shorter
+    return k < memory ? memory : k;
+}
+
+// Compares a window whose last byte matches, returns 0 on a match or how far to move it
+static size_t search_compare(const SearchNeedle *s, const uint8_t *h, const uint8_t *n, size_t nl, size_t *memory)
+{
+    size_t k;
+
+    // right half left to right, a mismatch moves the window past the bytes that matched
+    for (k = s->split > *memory ? s->split : *memory; k < nl && n[k] == h[k]; k++);
+    if (k < nl)
+    {
+        *memory = 0;
+        return k - s->split + 1;
+    }
+
+    // left half right to left, down to what the previous period shift left matching
+    for (k = s->split; k > *memory && n[k - 1] == h[k - 1]; k--);
+    if (k <= *memory)
+    {
+        return 0;
+    }
+    *memory = s->memory;
+    return s->period;
+}
+
+void *memmem(const void *haystack, size_t hl, const void *needle, size_t nl)
+{
+    const uint8_t *h = haystack;
+    const uint8_t *n = needle;
+    SearchNeedle s;
+    size_t memory = 0;
+
+    if (!nl)
+    {
+        return (void *)haystack;
+    }
+    if (nl > hl)
+    {
+        return NULL;
+    }
+    if (nl == 1)
+    {
+        return memchr(haystack, n[0], hl);
+    }
+
+    search_prepare(&s, n, nl);
+    for (size_t pos = 0; pos <= hl - nl;)
+    {
+        size_t k;
+        if (h[pos + nl - 1] != n[nl - 1])
+        {
+            k = search_skip(&s, h + pos, n, nl, hl - nl - pos, memory);
+            if (!k)
+            {
+                return NULL;
+            }
+            memory = 0;
+        }
+        else
+        {
+            k = search_compare(&s, h + pos, n, nl, &memory);
+            if (!k)
+            {
+                return (void *)(h + pos);
+            }
+        }
+        pos += k;
+    }
+    return NULL;
+}
+
+char *strstr(const char *haystack, const char *needle)
+{
+    const uint8_t *n = (const uint8_t *)needle;
+    SearchNeedle s;
+    size_t memory = 0;
+
+    if (!n[0])
+    {
+        return (char *)haystack;
+    }
+    const uint8_t *h = (const uint8_t *)strchr(haystack, n[0]);
+    if (!h || !n[1])
+    {
+        return (char *)h;
+    }
+
+    size_t nl = strlen(needle);
+    search_prepare(&s, n, nl);
+
+    // the haystack is only known to run up to end, found in chunks that
+    // double up to 64KB so a match near the start doesn't pay for a strlen
+    // of the rest
+    const uint8_t *end = h;
+    size_t grow = nl + 256;
+    for (;;)
+    {
+        if ((size_t)(end - h) < nl + 64)
+        {
+            grow = grow < 0x10000 ? grow * 2 : grow;
+            const uint8_t *nul = memchr(end, 0, grow);
+            if (nul && (size_t)(nul - h) < nl)
+            {
+                return NULL;
+            }
+            end = nul ? nul : end + grow;
+        }
+
+        size_t k;
+        if (h[nl - 1] != n[nl - 1])
+        {
+            k = search_skip(&s, h, n, nl, end - h - nl, memory);
+            if (!k)
+            {
+                // no match before end, carry on from the last window it allows
+                if (!*end)
+                {
+                    return NULL;
+                }
+                k = end - h - nl + 1;
+            }
+            memory = 0;
+        }
+        else
+        {
+            k = search_compare(&s, h, n, nl, &memory);
+            if (!k)
+            {
+                return (char *)h;
+            }
+        }
+        h += k;
+    }
+}
@@ -6,6 +6,27 @@
 int strcmp(const char *str1, const char *str2);
 char *strcpy(char *dest, const char *src);
 char *strtok(char *str, const char *delim);
+char *strtok_r(char *str, const char *delim, char **saveptr);
 size_t strlen(const char *str);
+char *strchr(const char *str, int c);
 char *strstr(const char *haystack, const char *needle);
+unsigned long strtoul(const char *str, char **endptr, int base);
+void *memcpy(void *dest, const void *src, size_t n);
+void *memmove(void *dest, const void *src, size_t n);
+void *memset(void *dest, int c, size_t n);
+int memcmp(const void *ptr1, const void *ptr2, size_t n);
+void *memchr(const void *ptr, int c, size_t n);
+void *memmem(const void *haystack, size_t hl, const void *needle, size_t nl);
+
+/**
+ * Split str in place at runs of delimiters, pointing argv at each token.
+ * Returns the token count, or -1 if there are more than max.
+ */
+int strsplit(char *str, const char *delim, char **argv, int max);
+
+// Byte at a time references for the NEON strcmp, strlen and strchr, and the naive strstr
+int strcmp_scalar(const char *str1, const char *str2);
+size_t strlen_scalar(const char *str);
+char *strchr_scalar(const char *str, int c);
+char *strstr_scalar(const char *haystack, const char *needle);
 #endif
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include "timer.h"
+
+/**
+ * Read the free running system counter
+ */
+unsigned long timer_ticks() {
+  unsigned long t;
+  asm volatile("isb; mrs %0, cntpct_el0" : "=r"(t));
+  return t;
+}
+
+/**
+ * Frequency of the system counter in Hz (19.2MHz on the real board, 62.5MHz in QEMU)
+ */
+unsigned long timer_freq() {
+  unsigned long f;
+  asm volatile("mrs %0, cntfrq_el0" : "=r"(f));
+  return f;
+}
+
+unsigned long timer_ticks_to_us(unsigned long ticks) {
+  unsigned long freq = timer_freq();
+  return freq ? (ticks * 1000000) / freq : 0;
+}
+
+/**
+ * Busy wait for the given number of milliseconds
+ */
+void wait_msec(unsigned int msec) {
+  unsigned long start = timer_ticks();
+  unsigned long wait = (timer_freq() * msec) / 1000;
+
+  while (timer_ticks() - start < wait) {
+    asm volatile("nop");
+  }
+}
+
+/**
+ * Enable and reset the PMU cycle counter
+ */
+void cycle_counter_init() {
+  unsigned long pmcr;
+
+  asm volatile("mrs %0, pmcr_el0" : "=r"(pmcr));
+  pmcr |= (1 << 0) | (1 << 2);  // E: enable counters, C: reset cycle counter
+  asm volatile("msr pmcr_el0, %0" : : "r"(pmcr));
+  asm volatile("msr pmcntenset_el0, %0" : : "r"(1UL << 31));  // enable PMCCNTR_EL0
+}
+
+/**
+ * Read the CPU cycle counter
+ */
+unsigned long cycles() {
+  unsigned long c;
+  asm volatile("isb; mrs %0, pmccntr_el0" : "=r"(c));
+  return c;
+}
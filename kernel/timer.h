@@ -0,0 +1,14 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+/* ARM generic timer helpers (CNTPCT_EL0 / CNTFRQ_EL0) */
+unsigned long timer_ticks();
+unsigned long timer_freq();
+unsigned long timer_ticks_to_us(unsigned long ticks);
+void wait_msec(unsigned int msec);
+
+/* PMU cycle counter (PMCCNTR_EL0) */
+void cycle_counter_init();
+unsigned long cycles();
+
+#endif
@@ -0,0 +1,272 @@
+// -----------------------------------bench_host.c -------------------------------------
+// Host microbenchmarks of the kernel libraries next to the C library (make host_bench).
+// Times are in cycles from the time stamp counter (x86) or the virtual counter (arm64),
+// nanoseconds elsewhere; best of several runs to hide interrupts.
+
+#define _GNU_SOURCE  // memmem
+#include "kern.h"
+#include "../kernel/hash.h"
+#include "../kernel/containers.h"
+#include "../kernel/slab.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#define TICKS "cycles"
+static inline uint64_t ticks() {
+  return __rdtsc();
+}
+#elif defined(__aarch64__)
+#define TICKS "ticks"
+static inline uint64_t ticks() {
+  uint64_t t;
+  asm volatile("isb; mrs %0, cntvct_el0" : "=r"(t));
+  return t;
+}
+#else
+#define TICKS "ns"
+static inline uint64_t ticks() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+#endif
+
+#define BENCH_REPEAT 2000
+#define BENCH_BEST_OF 7
+#define BENCH_MAX 65536
+
+static volatile uintptr_t sink;
+static char src[BENCH_MAX + 64] __attribute__((aligned(64)));
+static char dest[BENCH_MAX + 64] __attribute__((aligned(64)));
+
+// Best per-call time of body over BENCH_BEST_OF runs of BENCH_REPEAT calls
+#define MEASURE(result, body) \
+  do { \
+    uint64_t best_ = UINT64_MAX; \
+    for (int run_ = 0; run_ < BENCH_BEST_OF; run_++) { \
+      uint64_t start_ = ticks(); \
+      for (int rep_ = 0; rep_ < BENCH_REPEAT; rep_++) { \
+        body; \
+      } \
+      uint64_t spent_ = ticks() - start_; \
+      if (spent_ < best_) \
+        best_ = spent_; \
+    } \
+    result = (double)best_ / BENCH_REPEAT; \
+  } while (0)
+
+static const size_t sizes[] = {8, 64, 512, 4096, 65536};
+
+static void bench_strings() {
+  printf("\n%-8s %-8s %12s %12s\n", "call", "bytes", "kernel", "libc");
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    size_t n = sizes[i];
+    double kern, libc;
+
+    memset(src, 'a', n);
+    src[n - 1] = '#';
+    src[n] = '\0';
+    memcpy(dest, src, n + 1);
+
+    MEASURE(kern, sink = kern_strlen(src));
+    MEASURE(libc, sink = strlen(src));
+    printf("%-8s %-8zu %12.1f %12.1f\n", "strlen", n, kern, libc);
+
+    MEASURE(kern, sink = (uintptr_t)kern_strchr(src, '#'));
+    MEASURE(libc, sink = (uintptr_t)strchr(src, '#'));
+    printf("%-8s %-8zu %12.1f %12.1f\n", "strchr", n, kern, libc);
+
+    MEASURE(kern, sink = kern_strcmp(src, dest));
+    MEASURE(libc, sink = strcmp(src, dest));
+    printf("%-8s %-8zu %12.1f %12.1f\n", "strcmp", n, kern, libc);
+
+    MEASURE(kern, sink = (uintptr_t)kern_memcpy(dest, src, n));
+    MEASURE(libc, sink = (uintptr_t)memcpy(dest, src, n));
+    printf("%-8s %-8zu %12.1f %12.1f\n", "memcpy", n, kern, libc);
+
+    MEASURE(kern, sink = (uintptr_t)kern_memcpy(dest, src + 3, n));
+    MEASURE(libc, sink = (uintptr_t)memcpy(dest, src + 3, n));
+    printf("%-8s %-8zu %12.1f %12.1f\n", "memcpy+3", n, kern, libc);
+
+    MEASURE(kern, sink = (uintptr_t)kern_memmove(dest + 8, dest, n));
+    MEASURE(libc, sink = (uintptr_t)memmove(dest + 8, dest, n));
+    printf("%-8s %-8zu %12.1f %12.1f\n", "memmove", n, kern, libc);
+
+    MEASURE(kern, sink = (uintptr_t)kern_memset(dest, 0, n));
+    MEASURE(libc, sink = (uintptr_t)memset(dest, 0, n));
+    printf("%-8s %-8zu %12.1f %12.1f\n", "memset", n, kern, libc);
+
+    src[n - 1] = 'a';
+    MEASURE(kern, sink = (uintptr_t)kern_strstr(src, "aaaab"));
+    MEASURE(libc, sink = (uintptr_t)strstr(src, "aaaab"));
+    printf("%-8s %-8zu %12.1f %12.1f\n", "strstr", n, kern, libc);
+
+    MEASURE(kern, sink = (uintptr_t)kern_memmem(src, n, "mailbox call failed", 19));
+    MEASURE(libc, sink = (uintptr_t)memmem(src, n, "mailbox call failed", 19));
+    printf("%-8s %-8zu %12.1f %12.1f\n", "memmem", n, kern, libc);
+  }
+}
+
+static void bench_printf() {
+  char buffer[128];
+  double kern, libc;
+
+  printf("\n%-22s %12s %12s\n", "snprintf", "kernel", "libc");
+
+  MEASURE(kern, sink = kern_snprintf(buffer, sizeof(buffer), "%lu", 18446744073709551615UL));
+  MEASURE(libc, sink = snprintf(buffer, sizeof(buffer), "%lu", 18446744073709551615UL));
+  printf("%-22s %12.1f %12.1f\n", "%lu 20 digits", kern, libc);
+
+  MEASURE(kern, sink = kern_snprintf(buffer, sizeof(buffer), "%08lx", 0x80000UL));
+  MEASURE(libc, sink = snprintf(buffer, sizeof(buffer), "%08lx", 0x80000UL));
+  printf("%-22s %12.1f %12.1f\n", "%08lx", kern, libc);
+
+  MEASURE(kern, sink = kern_snprintf(buffer, sizeof(buffer), "%f", 3.141592653589793));
+  MEASURE(libc, sink = snprintf(buffer, sizeof(buffer), "%f", 3.141592653589793));
+  printf("%-22s %12.1f %12.1f\n", "%f pi", kern, libc);
+
+  MEASURE(kern, sink = kern_snprintf(buffer, sizeof(buffer), "%g", 6.02214076e23));
+  MEASURE(libc, sink = snprintf(buffer, sizeof(buffer), "%g", 6.02214076e23));
+  printf("%-22s %12.1f %12.1f\n", "%g avogadro", kern, libc);
+
+  MEASURE(kern, sink = kern_snprintf(buffer, sizeof(buffer), FMT_BENCH_LINE, 0x80000UL, 7, "ok", 3UL));
+  MEASURE(libc, sink = snprintf(buffer, sizeof(buffer), FMT_BENCH_LINE, 0x80000UL, 7, "ok", 3UL));
+  printf("%-22s %12.1f %12.1f\n", "bench line", kern, libc);
+
+  MEASURE(kern, sink = SNPRINTF_FMT(buffer, sizeof(buffer), BENCH_LINE, 0x80000UL, 7, "ok", 3UL));
+  printf("%-22s %12.1f\n", "bench line pre-parsed", kern);
+}
+
+static void bench_hash() {
+  static const size_t lengths[] = {4, 8, 16, 32, 64, 256};
+  double aligned, offset;
+
+  printf("\n%-8s %-8s %12s %12s\n", "call", "bytes", "aligned", "offset 3");
+  for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+    size_t n = lengths[i];
+    MEASURE(aligned, sink = hash_bytes(src, n, sink));
+    MEASURE(offset, sink = hash_bytes(src + 3, n, sink));
+    printf("%-8s %-8zu %12.1f %12.1f\n", "hash", n, aligned, offset);
+  }
+  MEASURE(aligned, sink = hash_u64(sink, 0));
+  printf("%-8s %-8d %12.1f\n", "hash_u64", 8, aligned);
+}
+
+#define NAME_EQUAL(a, b) (strcmp(a, b) == 0)
+HASHMAP_DEFINE(NameMap, const char *, int, hash_str, NAME_EQUAL)
+
+#define INT_LESS(a, b) (*(a) < *(b))
+HEAP_DEFINE(IntHeap, int, 1024, INT_LESS)
+
+RING_DEFINE(IntRing, int, 1024)
+
+// The shell's command names, looked up by a map and by the linear scan it replaced
+static const char *const names[] = {
+  "help", "clear", "setcolor", "showinfo", "set_baud", "set_databits", "set_stopbits",
+  "set_parity", "set_handshaking", "set_port", "set_fifo", "uartstat", "bench_fmt", "dlog",
+  "bench_printf", "bench_string", "bench_mem", "bench_search", "bench_dlog", "logmask",
+  "console", "dmesg", "crc32", "switch_baud",
+};
+#define NAME_COUNT (sizeof(names) / sizeof(names[0]))
+
+static int scan(const char *name) {
+  for (size_t i = 0; i < NAME_COUNT; i++)
+    if (strcmp(names[i], name) == 0)
+      return (int)i;
+  return -1;
+}
+
+static void bench_containers() {
+  static NameMap_slot slots[64];
+  static uint32_t tags[64];
+  static IntHeap heap;
+  static IntRing ring;
+  NameMap map;
+  double kern, linear;
+  int value = 0;
+  unsigned int pick = 0;  // cycles through every name
+
+  NameMap_init(&map, slots, tags, 64);
+  for (size_t i = 0; i < NAME_COUNT; i++)
+    NameMap_put(&map, names[i], (int)i);
+
+  printf("\n%-22s %12s %12s\n", "lookup", "hash map", "strcmp scan");
+  MEASURE(kern, sink += *NameMap_find(&map, names[pick++ % NAME_COUNT]));
+  MEASURE(linear, sink += scan(names[pick++ % NAME_COUNT]));
+  printf("%-22s %12.1f %12.1f\n", "command name", kern, linear);
+  MEASURE(kern, sink += NameMap_find(&map, "nosuchcommand") != NULL);
+  MEASURE(linear, sink += scan("nosuchcommand"));
+  printf("%-22s %12.1f %12.1f\n", "missing name", kern, linear);
+
+  printf("\n%-22s %12s\n", "1024 elements", "per element");
+  MEASURE(kern, {
+    IntHeap_init(&heap);
+    for (int i = 0; i < 1024; i++) {
+      value = (i * 7919) & 1023;
+      IntHeap_push(&heap, &value);
+    }
+    while (IntHeap_pop(&heap, &value) == 0)
+      sink += value;
+  });
+  printf("%-22s %12.1f\n", "heap push + pop", kern / 1024);
+  MEASURE(kern, {
+    IntRing_init(&ring);
+    for (int i = 0; i < 1024; i++)
+      IntRing_push(&ring, &i);
+    while (IntRing_pop(&ring, &value) == 0)
+      sink += value;
+  });
+  printf("%-22s %12.1f\n", "ring push + pop", kern / 1024);
+}
+
+static void bench_alloc() {
+  static const size_t sizes[] = {16, 64, 256, 2048, 16384};
+  static void *held[64];
+  uint8_t *arena = aligned_alloc(2UL << 20, 32UL << 20);
+  double kern, libc;
+
+  page_alloc_init((uintptr_t)arena, (uintptr_t)arena + (32UL << 20));
+  slab_init();
+
+  // a pair is served from the magazine, a burst of 64 goes through the slabs
+  printf("\n%-22s %12s %12s\n", "alloc + free", "kmalloc", "malloc");
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    size_t n = sizes[i];
+    char label[32];
+    MEASURE(kern, { void *p = kmalloc(n); sink += (uintptr_t)p; kfree(p); });
+    MEASURE(libc, { void *p = malloc(n); sink += (uintptr_t)p; free(p); });
+    snprintf(label, sizeof(label), "%zu bytes", n);
+    printf("%-22s %12.1f %12.1f\n", label, kern, libc);
+
+    MEASURE(kern, {
+      for (int k = 0; k < 64; k++)
+        held[k] = kmalloc(n);
+      for (int k = 0; k < 64; k++)
+        kfree(held[k]);
+    });
+    MEASURE(libc, {
+      for (int k = 0; k < 64; k++)
+        held[k] = malloc(n);
+      for (int k = 0; k < 64; k++)
+        free(held[k]);
+    });
+    snprintf(label, sizeof(label), "%zu bytes, 64 held", n);
+    printf("%-22s %12.1f %12.1f\n", label, kern / 64, libc / 64);
+  }
+  free(arena);
+}
+
+int main(void) {
+  printf("%s per call, best of %d runs of %d\n", TICKS, BENCH_BEST_OF, BENCH_REPEAT);
+  bench_strings();
+  bench_printf();
+  bench_hash();
+  bench_containers();
+  bench_alloc();
+  return 0;
+}
@@ -0,0 +1,22 @@
+#ifndef FUZZ_H
+#define FUZZ_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * libFuzzer entry point. Each fuzz_*.c defines it; link with clang
+ * -fsanitize=fuzzer, or with fuzz_main.c where libFuzzer isn't available.
+ */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+// Abort with a message so both drivers report the failing input
+#define FUZZ_ASSERT(cond) \
+  do { \
+    if (!(cond)) { \
+      fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      abort(); \
+    } \
+  } while (0)
+
+#endif
@@ -0,0 +1,109 @@
+// -----------------------------------fuzz_main.c -------------------------------------
+// Stand-alone driver for the libFuzzer targets when clang isn't available.
+// Runs each file given on the command line, then random inputs built by
+// mutating the previous one.
+//
+// Usage: fuzz_string [-runs=N] [-seed=N] [files...]
+
+#include "fuzz.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FUZZ_MAX_INPUT 4096
+
+static uint64_t rngState = 0x9E3779B97F4A7C15UL;
+
+static uint64_t rng() {
+  // xorshift64*
+  rngState ^= rngState >> 12;
+  rngState ^= rngState << 25;
+  rngState ^= rngState >> 27;
+  return rngState * 0x2545F4914F6CDD1DUL;
+}
+
+static void run_file(const char *path) {
+  static uint8_t data[FUZZ_MAX_INPUT];
+  FILE *f = fopen(path, "rb");
+
+  if (!f) {
+    perror(path);
+    exit(2);
+  }
+  size_t size = fread(data, 1, sizeof(data), f);
+  fclose(f);
+  LLVMFuzzerTestOneInput(data, size);
+}
+
+// Small edits keep most of the structure, a fresh input now and then escapes it
+static size_t mutate(uint8_t *data, size_t size) {
+  int edits = 1 + rng() % 4;
+
+  if (rng() % 16 == 0 || size == 0) {
+    size = rng() % (rng() % 4 ? 64 : FUZZ_MAX_INPUT);
+    for (size_t i = 0; i < size; i++) {
+      data[i] = (uint8_t)rng();
+    }
+    return size;
+  }
+
+  while (edits--) {
+    size_t at = rng() % size;
+    switch (rng() % 5) {
+    case 0:  // flip a bit
+      data[at] ^= 1 << (rng() % 8);
+      break;
+    case 1:  // random byte
+      data[at] = (uint8_t)rng();
+      break;
+    case 2:  // printable byte, most targets parse text
+      data[at] = ' ' + rng() % 95;
+      break;
+    case 3:  // insert
+      if (size < FUZZ_MAX_INPUT) {
+        memmove(data + at + 1, data + at, size - at);
+        data[at] = (uint8_t)rng();
+        size++;
+      }
+      break;
+    default:  // erase
+      memmove(data + at, data + at + 1, size - at - 1);
+      size--;
+      break;
+    }
+    if (!size) {
+      break;
+    }
+  }
+  return size;
+}
+
+int main(int argc, char **argv) {
+  static uint8_t data[FUZZ_MAX_INPUT];
+  long runs = 100000;
+  size_t size = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "-runs=", 6) == 0) {
+      runs = atol(argv[i] + 6);
+    }
+    else if (strncmp(argv[i], "-seed=", 6) == 0) {
+      rngState = strtoull(argv[i] + 6, NULL, 0) | 1;
+    }
+    else {
+      run_file(argv[i]);
+    }
+  }
+
+  for (long n = 0; n < runs; n++) {
+    size = mutate(data, size);
+    // the target gets its own copy, sized exactly, so overreads show up under ASan
+    uint8_t *copy = malloc(size ? size : 1);
+    memcpy(copy, data, size);
+    LLVMFuzzerTestOneInput(copy, size);
+    free(copy);
+  }
+  printf("%s: %ld runs\n", argv[0], runs);
+  return 0;
+}
@@ -0,0 +1,143 @@
+// -----------------------------------fuzz_printf.c -------------------------------------
+// Fuzzing of cli/printf.c. Every conversion is compared with the C library,
+// floats must also round-trip and keep the return value honest.
+//
+// Strings and characters pad on the right in the kernel, so the C library
+// gets the '-' flag for those.
+//
+// Input bytes below 0x80 are literal text, a byte with the top bit set starts
+// a conversion: its low bits pick the conversion, the next byte the flags,
+// width and precision, and the following 8 bytes the argument.
+
+#include "fuzz.h"
+#include "kern.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static const char intConvs[] = "diuxXoc";
+static const char floatConvs[] = "feEgG";
+
+static uint64_t read_u64(const uint8_t *data) {
+  uint64_t v = 0;
+  for (int i = 0; i < 8; i++) {
+    v |= (uint64_t)data[i] << (8 * i);
+  }
+  return v;
+}
+
+// Append "%[-][0][width][.precision][l]<conv>" to format
+static int build_spec(char *format, int len, uint8_t flags, int isLong, char conv, int left) {
+  len += sprintf(format + len, "%%%s%s", left ? "-" : "", (flags & 1) ? "0" : "");
+  if (flags & 2) {
+    len += sprintf(format + len, "%d", (flags >> 2) & 15);
+  }
+  if (flags & 0x40) {
+    len += sprintf(format + len, ".%d", (flags >> 4) & 3 ? (flags >> 4) & 3 : 0);
+  }
+  return len + sprintf(format + len, "%s%c", isLong ? "l" : "", conv);
+}
+
+static void check_float(const char *format, double value) {
+  char got[512], want[512];
+  int len = kern_snprintf(got, sizeof(got), format, value);
+
+  FUZZ_ASSERT(len >= 0);
+  FUZZ_ASSERT((size_t)len < sizeof(got) ? strlen(got) == (size_t)len : strlen(got) == sizeof(got) - 1);
+
+  // the exact value rounded to the precision, as the C library does
+  int wantLen = snprintf(want, sizeof(want), format, value);
+  if (len != wantLen || strcmp(got, want) != 0) {
+    fprintf(stderr, "format \"%s\" of %a: got \"%s\", expected \"%s\"\n", format, value, got, want);
+    FUZZ_ASSERT(0);
+  }
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  char format[64];
+  int len = 0;
+
+  while (size) {
+    uint8_t b = *data++;
+    size--;
+
+    if (!(b & 0x80)) {
+      // literal text, '%' doubled so it prints as itself
+      if (b >= ' ' && len < 32) {
+        format[len++] = (char)b;
+        if (b == '%') {
+          format[len++] = '%';
+        }
+      }
+      continue;
+    }
+    if (size < 9) {
+      break;
+    }
+
+    uint8_t flags = data[0];
+    uint64_t raw = read_u64(data + 1);
+    data += 9;
+    size -= 9;
+    char got[128], want[128];
+
+    if (b & 0x40) {
+      // floating point, built from the raw bits so every class shows up
+      double value;
+      memcpy(&value, &raw, sizeof(value));
+      len = build_spec(format, len, flags, 0, floatConvs[(b & 0x3F) % 5], 0);
+      format[len] = '\0';
+      check_float(format, value);
+
+      if (isfinite(value)) {
+        kern_snprintf(got, sizeof(got), "%.17e", value);
+        FUZZ_ASSERT(strtod(got, NULL) == value);
+      }
+    }
+    else if ((b & 0x3F) % 8 == 7) {
+      // strings, any bytes up to the first NUL
+      char text[9];
+      memcpy(text, &raw, 8);
+      text[8] = '\0';
+      char libcFormat[64];
+      memcpy(libcFormat, format, len);
+      build_spec(libcFormat, len, flags & ~1, 0, 's', 1);
+      len = build_spec(format, len, flags & ~1, 0, 's', 0);
+      int gotLen = kern_snprintf(got, sizeof(got), format, text);
+      int wantLen = snprintf(want, sizeof(want), libcFormat, text);
+      if (gotLen != wantLen || strcmp(got, want) != 0) {
+        fprintf(stderr, "format \"%s\": got \"%s\", expected \"%s\"\n", format, got, want);
+        abort();
+      }
+    }
+    else {
+      char conv = intConvs[(b & 0x3F) % 7];
+      int isLong = (b & 0x20) && conv != 'c';
+      // the 0 flag and a precision with %c are undefined in C, leave them out
+      uint8_t specFlags = conv == 'c' ? flags & ~0x41 : flags;
+      char libcFormat[64];
+      memcpy(libcFormat, format, len);
+      build_spec(libcFormat, len, specFlags, isLong, conv, conv == 'c');
+      len = build_spec(format, len, specFlags, isLong, conv, 0);
+
+      int gotLen, wantLen;
+      if (isLong) {
+        gotLen = kern_snprintf(got, sizeof(got), format, (long)raw);
+        wantLen = snprintf(want, sizeof(want), libcFormat, (long)raw);
+      }
+      else {
+        int value = conv == 'c' ? ' ' + (int)(raw % 95) : (int)raw;
+        gotLen = kern_snprintf(got, sizeof(got), format, value);
+        wantLen = snprintf(want, sizeof(want), libcFormat, value);
+      }
+      if (gotLen != wantLen || strcmp(got, want) != 0) {
+        fprintf(stderr, "format \"%s\": got \"%s\", expected \"%s\"\n", format, got, want);
+        abort();
+      }
+    }
+    len = 0;
+  }
+  return 0;
+}
@@ -0,0 +1,100 @@
+// -----------------------------------fuzz_string.c -------------------------------------
+// Differential fuzzing of kernel/string.c against the C library.
+// Input: one control byte (offsets), then haystack and needle split at the first 0.
+
+#define _GNU_SOURCE  // memmem
+#include "fuzz.h"
+#include "kern.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int sign(int x) {
+  return (x > 0) - (x < 0);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  if (size < 1) {
+    return 0;
+  }
+
+  unsigned int control = data[0];
+  const uint8_t *body = data + 1;
+  size_t bodyLen = size - 1;
+  const uint8_t *split = memchr(body, 0, bodyLen);
+  size_t hl = split ? (size_t)(split - body) : bodyLen;
+  size_t nl = split ? bodyLen - hl - 1 : 0;
+
+  // NUL terminated copies at the offset chosen by the control byte
+  size_t offset = control & 15;
+  char *hay = malloc(offset + hl + 1);
+  char *needle = malloc(nl + 1);
+  memcpy(hay + offset, body, hl);
+  hay[offset + hl] = '\0';
+  memcpy(needle, split ? split + 1 : body, nl);
+  needle[nl] = '\0';
+  char *h = hay + offset;
+
+  // searching
+  FUZZ_ASSERT(kern_memmem(h, hl, needle, nl) == memmem(h, hl, needle, nl));
+  FUZZ_ASSERT(kern_strstr(h, needle) == strstr(h, needle));
+  if (nl) {
+    FUZZ_ASSERT(kern_memchr(h, needle[0], hl) == memchr(h, needle[0], hl));
+    FUZZ_ASSERT(kern_strchr(h, needle[0]) == strchr(h, needle[0]));
+  }
+  FUZZ_ASSERT(kern_strlen(h) == strlen(h));
+  FUZZ_ASSERT(sign(kern_strcmp(h, needle)) == sign(strcmp(h, needle)));
+  size_t common = hl < nl ? hl : nl;
+  FUZZ_ASSERT(sign(kern_memcmp(h, needle, common)) == sign(memcmp(h, needle, common)));
+
+  // copying, into a buffer with guard bytes around the destination
+  size_t destOffset = control >> 4;
+  uint8_t *got = malloc(hl + 32);
+  uint8_t *want = malloc(hl + 32);
+  memset(got, 0xA5, hl + 32);
+  memset(want, 0xA5, hl + 32);
+  kern_memcpy(got + destOffset, h, hl);
+  memcpy(want + destOffset, h, hl);
+  FUZZ_ASSERT(memcmp(got, want, hl + 32) == 0);
+
+  // overlapping move within the haystack copy
+  if (hl) {
+    size_t from = control % hl;
+    size_t to = (control * 7) % hl;
+    size_t n = hl - (from > to ? from : to);
+    memcpy(got, h, hl);
+    memcpy(want, h, hl);
+    kern_memmove(got + to, got + from, n);
+    memmove(want + to, want + from, n);
+    FUZZ_ASSERT(memcmp(got, want, hl) == 0);
+
+    kern_memset(got + from, (int)control, n);
+    memset(want + from, (int)control, n);
+    FUZZ_ASSERT(memcmp(got, want, hl) == 0);
+  }
+
+  // splitting: every token is non-empty, free of delimiters and in order
+  char *argv[64];
+  char *line = strdup(h);
+  int argc = strsplit(line, " \t", argv, 64);
+  FUZZ_ASSERT(argc >= -1 && argc <= 64);
+  for (int i = 0; i < argc; i++) {
+    FUZZ_ASSERT(argv[i][0] != '\0');
+    FUZZ_ASSERT(strpbrk(argv[i], " \t") == NULL);
+    FUZZ_ASSERT(i == 0 || argv[i] > argv[i - 1]);
+  }
+
+  // strtoul stops at the first byte that isn't a digit of the base
+  int base = 2 + control % 35;
+  char *end;
+  kern_strtoul(h, &end, base);
+  FUZZ_ASSERT(end >= h && end <= h + hl);
+
+  free(line);
+  free(got);
+  free(want);
+  free(needle);
+  free(hay);
+  return 0;
+}
@@ -0,0 +1,70 @@
+#ifndef HOST_H
+#define HOST_H
+
+/*
+ * Force-included (-include ./test/host.h) when the kernel libraries are
+ * built for the Linux host. Names the C library also defines get a kern_
+ * prefix so a test can call both, and cpu.h is replaced by host stand-ins.
+ * Test sources include kern.h instead.
+ */
+
+#define strcmp    kern_strcmp
+#define strcpy    kern_strcpy
+#define strtok    kern_strtok
+#define strtok_r  kern_strtok_r
+#define strlen    kern_strlen
+#define strchr    kern_strchr
+#define strstr    kern_strstr
+#define strtoul   kern_strtoul
+#define memcpy    kern_memcpy
+#define memmove   kern_memmove
+#define memset    kern_memset
+#define memcmp    kern_memcmp
+#define memchr    kern_memchr
+#define memmem    kern_memmem
+#define printf    kern_printf
+#define vprintf   kern_vprintf
+#define snprintf  kern_snprintf
+#define vsnprintf kern_vsnprintf
+
+// cpu.h on the host: a single core. An aarch64 host uses DC ZVA and the CRC32
+// instructions as far as Linux allows them, other hosts the portable paths.
+#define CPU_H
+#define CPU_CORES       4
+#define CACHE_LINE_SIZE 64
+
+static inline unsigned int cpu_id() {
+  return 0;
+}
+
+static inline void cpu_dmb() {
+  __sync_synchronize();
+}
+
+#if defined(__aarch64__)
+unsigned long getauxval(unsigned long type);
+
+#define HOST_AT_HWCAP    16        // <sys/auxv.h>
+#define HOST_HWCAP_CRC32 (1 << 7)  // <asm/hwcap.h>
+
+// user memory is Normal, only DCZID_EL0.DZP can rule DC ZVA out
+static inline unsigned int cpu_zva_size() {
+  unsigned long dczid;
+  asm volatile("mrs %0, dczid_el0" : "=r"(dczid));
+  return (dczid & 0x10) ? 0 : 4 << (dczid & 0xF);
+}
+
+static inline int cpu_has_crc32() {
+  return (getauxval(HOST_AT_HWCAP) & HOST_HWCAP_CRC32) != 0;
+}
+#else
+static inline unsigned int cpu_zva_size() {
+  return 0;
+}
+
+static inline int cpu_has_crc32() {
+  return 0;
+}
+#endif
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef KERN_H
+#define KERN_H
+
+/*
+ * Declarations of the kernel libraries for host test sources: the kernel
+ * headers under their kern_ names (see host.h), after which the plain names
+ * refer to the C library again.
+ */
+
+#include "host.h"
+#include "../kernel/string.h"
+#include "../cli/printf.h"
+#include "mock_uart.h"
+
+#undef strcmp
+#undef strcpy
+#undef strtok
+#undef strtok_r
+#undef strlen
+#undef strchr
+#undef strstr
+#undef strtoul
+#undef memcpy
+#undef memmove
+#undef memset
+#undef memcmp
+#undef memchr
+#undef memmem
+#undef printf
+#undef vprintf
+#undef snprintf
+#undef vsnprintf
+
+#endif
@@ -0,0 +1,43 @@
+// -----------------------------------mock_uart.c -------------------------------------
+// Stands in for the console and UART on the host: console_write and uart_sendc
+// append to a buffer the tests read back with mock_uart_take. There is no input,
+// uart_getc returns an empty line, and no log port for dlog_flush.
+
+#include "mock_uart.h"
+#include "../kernel/console.h"
+#include "../kernel/dlog.h"
+#include "../uart/uart.h"
+
+static char output[MOCK_UART_SIZE + 1];
+static char taken[MOCK_UART_SIZE + 1];
+static size_t outputLen = 0;
+
+void console_write(const char *data, size_t len) {
+  while (len-- && outputLen < MOCK_UART_SIZE) {
+    output[outputLen++] = *data++;
+  }
+}
+
+void console_flush() {
+}
+
+void uart_sendc(char c) {
+  console_write(&c, 1);
+}
+
+char uart_getc() {
+  return '\n';
+}
+
+int dlog_flush() {
+  return 0;
+}
+
+const char *mock_uart_take() {
+  for (size_t i = 0; i < outputLen; i++) {
+    taken[i] = output[i];
+  }
+  taken[outputLen] = '\0';
+  outputLen = 0;
+  return taken;
+}
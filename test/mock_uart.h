@@ -0,0 +1,14 @@
+#ifndef MOCK_UART_H
+#define MOCK_UART_H
+
+#include "../gcclib/stddef.h"
+
+// Console output captured by the mock UART, printf ends up here on the host
+#define MOCK_UART_SIZE 4096
+
+/**
+ * Text written since the last call (NUL terminated), then start over
+ */
+const char *mock_uart_take();
+
+#endif
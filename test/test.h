@@ -0,0 +1,115 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/*
+ * Minimal unit test helpers: a failed check prints where and why, and the
+ * run continues so one pass shows every failure.
+ */
+
+extern int testChecks;
+extern int testFailures;
+
+#define CHECK(cond) \
+  do { \
+    testChecks++; \
+    if (!(cond)) { \
+      testFailures++; \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+    } \
+  } while (0)
+
+#define CHECK_STR(actual, expected) \
+  do { \
+    const char *a_ = (actual), *e_ = (expected); \
+    testChecks++; \
+    if (!a_ || strcmp(a_, e_) != 0) { \
+      testFailures++; \
+      fprintf(stderr, "%s:%d: got \"%s\", expected \"%s\"\n", __FILE__, __LINE__, a_ ? a_ : "(null)", e_); \
+    } \
+  } while (0)
+
+#define CHECK_INT(actual, expected) \
+  do { \
+    long a_ = (long)(actual), e_ = (long)(expected); \
+    testChecks++; \
+    if (a_ != e_) { \
+      testFailures++; \
+      fprintf(stderr, "%s:%d: %s is %ld, expected %ld\n", __FILE__, __LINE__, #actual, a_, e_); \
+    } \
+  } while (0)
+
+/*
+ * Allocator churn, shared by the page and slab suites. Each step picks a
+ * random slot: a live block there has its fill checked and is freed,
+ * otherwise alloc picks a size from the random value and the new block gets
+ * the slot number written every 16 bytes (the smallest size class) and into
+ * its last byte.
+ */
+#define TEST_ARENA_BYTES (16UL << 20)
+
+typedef struct {
+  uint8_t *ptr;
+  size_t len;
+} TestBlock;
+
+typedef void *(*TestAllocFn)(uint32_t random, size_t *len);  // NULL if out of memory
+typedef void (*TestFreeFn)(void *ptr);
+
+// Host memory for an allocator to manage, aligned to the page allocator's 2MB blocks
+static inline uint8_t *test_arena() {
+  return aligned_alloc(2UL << 20, TEST_ARENA_BYTES);
+}
+
+// Returns the number of blocks whose fill changed while they were live
+static inline int test_churn(TestBlock *slots, int count, int steps, uint32_t seed,
+                             TestAllocFn alloc, TestFreeFn release) {
+  int bad = 0;
+
+  for (int step = 0; step < steps; step++) {
+    seed = seed * 1103515245 + 12345;
+    int slot = (seed >> 8) % count;
+    TestBlock *block = &slots[slot];
+
+    if (block->ptr) {
+      for (size_t i = 0; i < block->len; i += 16)
+        bad += block->ptr[i] != (uint8_t)slot;
+      bad += block->ptr[block->len - 1] != (uint8_t)slot;
+      release(block->ptr);
+      block->ptr = NULL;
+      continue;
+    }
+    block->ptr = alloc(seed, &block->len);
+    if (block->ptr) {
+      for (size_t i = 0; i < block->len; i += 16)
+        block->ptr[i] = (uint8_t)slot;
+      block->ptr[block->len - 1] = (uint8_t)slot;
+    }
+  }
+  return bad;
+}
+
+// Free every block test_churn left live
+static inline void test_churn_end(TestBlock *slots, int count, TestFreeFn release) {
+  for (int slot = 0; slot < count; slot++) {
+    if (slots[slot].ptr)
+      release(slots[slot].ptr);
+    slots[slot].ptr = NULL;
+  }
+}
+
+// Test suites, one per library
+void test_string();
+void test_printf();
+void test_crc32();
+void test_hash();
+void test_containers();
+void test_page_alloc();
+void test_slab();
+void test_cli();
+
+#endif
@@ -0,0 +1,212 @@
+// -----------------------------------test_cli.c -------------------------------------
+// cli/cli.c and cli/lookup.c: splitting a line into argc/argv, dispatch through
+// processCommand and the NameMap lookups, over a command table of the test's own
+
+#include "test.h"
+#include "kern.h"
+#include "../cli/cli.h"
+#include "../cli/command.h"
+
+// What the last handler call saw, argv copied out of the line
+static int calls = 0;
+static int lastArgc = 0;
+static char lastArgv[CLI_MAX_ARGS][32];
+
+static void record(int argc, char **argv) {
+  calls++;
+  lastArgc = argc;
+  for (int i = 0; i < argc && i < CLI_MAX_ARGS; i++)
+    snprintf(lastArgv[i], sizeof(lastArgv[i]), "%s", argv[i]);
+}
+
+// The first entries are named, the rest get filler names in fill_commands
+#define NAMED_COMMANDS 6
+Command commandList[COMMAND_COUNT] = {
+  {"help", "", record},
+  {"help <command_name>", ""},
+  {"set_baud", "", record},
+  {"set_databits", "", record},
+  {"setcolor", "", record},
+  {"nohandler", ""},
+};
+
+ColorMap colorMappings[COLOR_COUNT] = {
+  {"black", "\033[1;30m", "\x1b[40m"},
+  {"red", "\033[1;31m", "\x1b[41m"},
+  {"green", "\033[1;32m", "\x1b[42m"},
+  {"yellow", "\033[1;33m", "\x1b[43m"},
+  {"blue", "\033[1;34m", "\x1b[44m"},
+  {"purple", "\033[1;35m", "\x1b[45m"},
+  {"cyan", "\033[1;36m", "\x1b[46m"},
+  {"white", "\033[1;37m", "\x1b[47m"}
+};
+
+// Before the first lookup, the maps are built from the table then
+static void fill_commands() {
+  static char names[COMMAND_COUNT][16];
+
+  for (int i = NAMED_COMMANDS; i < COMMAND_COUNT; i++) {
+    snprintf(names[i], sizeof(names[i]), "filler%02d", i);
+    commandList[i].name = names[i];
+    commandList[i].description = "";
+    commandList[i].handler = record;
+  }
+}
+
+static void test_split() {
+  char *argv[8];
+
+  // runs of delimiters count as one, argv points into the line
+  char line[] = "  set_baud\t 9600   8 ";
+  CHECK_INT(strsplit(line, " ", argv, 8), 3);
+  CHECK_STR(argv[0], "set_baud\t");
+  CHECK(argv[1] == line + 12);
+  CHECK_STR(argv[1], "9600");
+  CHECK_STR(argv[2], "8");
+
+  char tabs[] = "a\tb  \t c";
+  CHECK_INT(strsplit(tabs, " \t", argv, 8), 3);
+  CHECK_STR(argv[0], "a");
+  CHECK_STR(argv[1], "b");
+  CHECK_STR(argv[2], "c");
+
+  char empty[] = "";
+  CHECK_INT(strsplit(empty, " ", argv, 8), 0);
+
+  // quotes mean nothing to the splitter: a quoted phrase is split at its
+  // spaces and the quotes stay in the words
+  char quoted[] = "setcolor -t \"light blue\" ''";
+  CHECK_INT(strsplit(quoted, " ", argv, 8), 5);
+  CHECK_STR(argv[2], "\"light");
+  CHECK_STR(argv[3], "blue\"");
+  CHECK_STR(argv[4], "''");
+}
+
+static void test_split_limits() {
+  char *argv[CLI_MAX_ARGS + 1];
+  char line[128];
+
+  // exactly max words fit, one more fails without writing past argv[max - 1]
+  strcpy(line, "0 1 2 3 4 5 6 7 8 9 a b c d e f");
+  CHECK_INT(strsplit(line, " ", argv, CLI_MAX_ARGS), CLI_MAX_ARGS);
+  CHECK_STR(argv[CLI_MAX_ARGS - 1], "f");
+
+  strcpy(line, "0 1 2 3 4 5 6 7 8 9 a b c d e f g");
+  argv[CLI_MAX_ARGS] = line;
+  CHECK_INT(strsplit(line, " ", argv, CLI_MAX_ARGS), -1);
+  CHECK(argv[CLI_MAX_ARGS] == line);
+
+  // trailing delimiters after the last word don't count against the limit
+  strcpy(line, "0 1 2 3 4 5 6 7 8 9 a b c d e f    ");
+  CHECK_INT(strsplit(line, " ", argv, CLI_MAX_ARGS), CLI_MAX_ARGS);
+
+  char one[] = "word";
+  CHECK_INT(strsplit(one, " ", argv, 1), 1);
+  char two[] = "two words";
+  CHECK_INT(strsplit(two, " ", argv, 1), -1);
+}
+
+static void test_process() {
+  char line[128];
+
+  mock_uart_take();
+  calls = 0;
+  strcpy(line, "  set_baud   9600 ");
+  processCommand(line);
+  CHECK_INT(calls, 1);
+  CHECK_INT(lastArgc, 2);
+  CHECK_STR(lastArgv[0], "set_baud");
+  CHECK_STR(lastArgv[1], "9600");
+  CHECK_STR(mock_uart_take(), "\n");
+
+  // a blank line prints nothing
+  strcpy(line, "   ");
+  processCommand(line);
+  CHECK_INT(calls, 1);
+  CHECK_STR(mock_uart_take(), "");
+
+  // names match whole and case sensitive, quotes are part of the name
+  strcpy(line, "set_bau 9600");
+  processCommand(line);
+  CHECK_STR(mock_uart_take(), "\nCommand not found: set_bau. Please use help to view all valid commands.");
+  strcpy(line, "HELP");
+  processCommand(line);
+  CHECK_STR(mock_uart_take(), "\nCommand not found: HELP. Please use help to view all valid commands.");
+  strcpy(line, "\"help\"");
+  processCommand(line);
+  CHECK_STR(mock_uart_take(), "\nCommand not found: \"help\". Please use help to view all valid commands.");
+
+  // an entry without a handler is only there for help
+  strcpy(line, "nohandler");
+  processCommand(line);
+  CHECK_STR(mock_uart_take(), "\nCommand not found: nohandler. Please use help to view all valid commands.");
+  CHECK_INT(calls, 1);
+
+  // the command name and CLI_MAX_ARGS - 1 arguments, then one too many
+  strcpy(line, "setcolor 1 2 3 4 5 6 7 8 9 a b c d e f");
+  processCommand(line);
+  CHECK_INT(calls, 2);
+  CHECK_INT(lastArgc, CLI_MAX_ARGS);
+  CHECK_STR(lastArgv[CLI_MAX_ARGS - 1], "f");
+  mock_uart_take();
+
+  strcpy(line, "setcolor 1 2 3 4 5 6 7 8 9 a b c d e f g");
+  processCommand(line);
+  CHECK_INT(calls, 2);
+  CHECK_STR(mock_uart_take(), "\nToo many arguments, a command takes at most 15.");
+}
+
+static void test_lookup() {
+  char name[32];
+
+  // every entry by its own name, and by an equal string elsewhere in memory
+  for (int i = 0; i < COMMAND_COUNT; i++) {
+    CHECK(findCommand(commandList[i].name) == &commandList[i]);
+    strcpy(name, commandList[i].name);
+    CHECK(findCommand(name) == &commandList[i]);
+  }
+
+  CHECK(findCommand("") == NULL);
+  CHECK(findCommand("hel") == NULL);
+  CHECK(findCommand("helpx") == NULL);
+  CHECK(findCommand("Help") == NULL);
+  CHECK(findCommand("filler99") == NULL);
+
+  for (int i = 0; i < COLOR_COUNT; i++) {
+    strcpy(name, colorMappings[i].colorName);
+    CHECK(findTextColor(name) == colorMappings[i].textColorAscii);
+    CHECK(findAsciiBgColor(name) == colorMappings[i].bgColorAscii);
+  }
+  CHECK(findTextColor("Red") == NULL);
+  CHECK(findAsciiBgColor("") == NULL);
+  CHECK(findTextColor("set_baud") == NULL);
+}
+
+static void test_autocomplete() {
+  char buffer[100];
+  int index;
+
+  // the first entry the buffer is a prefix of
+  strcpy(buffer, "set_");
+  index = 4;
+  autocompleteHandler(buffer, &index);
+  CHECK_STR(buffer, "set_baud");
+  CHECK_INT(index, 8);
+  CHECK_STR(mock_uart_take(), "\rMyBareOS> set_baud");
+
+  strcpy(buffer, "nosuch");
+  index = 6;
+  autocompleteHandler(buffer, &index);
+  CHECK_STR(buffer, "nosuch");
+  CHECK_INT(index, 6);
+  CHECK_STR(mock_uart_take(), "");
+}
+
+void test_cli() {
+  fill_commands();
+  test_split();
+  test_split_limits();
+  test_process();
+  test_lookup();
+  test_autocomplete();
+}
@@ -0,0 +1,208 @@
+// -----------------------------------test_containers.c -------------------------------------
+// kernel/containers.h: the hash map against a plain array, ring wrap-around, heap order, lists
+
+#include "test.h"
+#include "kern.h"
+#include "../kernel/hash.h"
+#include "../kernel/containers.h"
+
+#define KEY_HASH(key) hash_u64(key, 0)
+#define KEY_EQUAL(a, b) ((a) == (b))
+HASHMAP_DEFINE(IntMap, uint64_t, int, KEY_HASH, KEY_EQUAL)
+
+// Every key collides, so the probe runs are as long as they get
+#define SAME_HASH(key) 0
+HASHMAP_DEFINE(CollideMap, uint64_t, int, SAME_HASH, KEY_EQUAL)
+
+#define INT_LESS(a, b) (*(a) < *(b))
+HEAP_DEFINE(IntHeap, int, 512, INT_LESS)
+
+RING_DEFINE(IntRing, int, 8)
+
+typedef struct {
+  int value;
+  ListNode node;
+} Item;
+
+#define MAP_SIZE 1024
+#define KEY_RANGE 1500
+
+// Robin Hood order: each entry's distance matches its slot, and no entry sits
+// more than one step further from home than the entry before it
+static int map_consistent(IntMap *map) {
+  uint32_t count = 0;
+  for (uint32_t i = 0; i <= map->mask; i++) {
+    uint32_t tag = map->tags[i];
+    if (!tag)
+      continue;
+    count++;
+    uint32_t home = (uint32_t)KEY_HASH(map->slots[i].key) & map->mask;
+    if (HASHMAP_DIST(tag) != ((i - home) & map->mask) + 1)
+      return 0;
+    uint32_t prev = map->tags[(i - 1) & map->mask];
+    if (HASHMAP_DIST(tag) > HASHMAP_DIST(prev) + 1)
+      return 0;
+  }
+  return count == map->count;
+}
+
+static void test_map() {
+  static IntMap_slot slots[MAP_SIZE];
+  static uint32_t tags[MAP_SIZE];
+  static int shadow[KEY_RANGE];  // 0 = absent, else value
+  IntMap map;
+  uint32_t state = 1;
+  int mismatches = 0;
+
+  IntMap_init(&map, slots, tags, MAP_SIZE);
+  CHECK(IntMap_find(&map, 5) == NULL);
+  CHECK_INT(IntMap_remove(&map, 5), -1);
+
+  // random puts and removes, checked against the shadow array
+  for (int step = 0; step < 200000; step++) {
+    state = state * 1103515245 + 12345;
+    uint64_t key = (state >> 8) % KEY_RANGE;
+    int *value = IntMap_find(&map, key);
+
+    if ((value ? *value : 0) != shadow[key])
+      mismatches++;
+    if (state & 0x80000000u) {
+      int ok = IntMap_put(&map, key, step + 1) == 0;
+      if (ok)
+        shadow[key] = step + 1;
+      else if (map.count < MAP_SIZE * 7 / 8)
+        mismatches++;
+    }
+    else {
+      if (IntMap_remove(&map, key) != (shadow[key] ? 0 : -1))
+        mismatches++;
+      shadow[key] = 0;
+    }
+    if (step % 10000 == 0)
+      CHECK(map_consistent(&map));
+  }
+  CHECK_INT(mismatches, 0);
+  CHECK(map_consistent(&map));
+
+  // iteration visits each entry once
+  uint32_t pos = 0, seen = 0;
+  for (IntMap_slot *slot; (slot = IntMap_next(&map, &pos));) {
+    if (shadow[slot->key] != slot->value)
+      mismatches++;
+    seen++;
+  }
+  CHECK_INT(mismatches, 0);
+  CHECK_INT(seen, map.count);
+
+  // fills to 7/8 and no further
+  IntMap_init(&map, slots, tags, 16);
+  for (uint64_t key = 0; key < 14; key++)
+    CHECK_INT(IntMap_put(&map, key, (int)key), 0);
+  CHECK_INT(IntMap_put(&map, 99, 0), -1);
+  CHECK_INT(IntMap_put(&map, 3, 33), 0);  // replacing still works
+  CHECK_INT(*IntMap_find(&map, 3), 33);
+
+  // one long collision run, removed from the middle
+  static CollideMap_slot cslots[64];
+  static uint32_t ctags[64];
+  CollideMap collide;
+  CollideMap_init(&collide, cslots, ctags, 64);
+  for (uint64_t key = 0; key < 40; key++)
+    CollideMap_put(&collide, key, (int)key);
+  for (uint64_t key = 0; key < 40; key += 3)
+    CHECK_INT(CollideMap_remove(&collide, key), 0);
+  for (uint64_t key = 0; key < 40; key++) {
+    int *value = CollideMap_find(&collide, key);
+    if (key % 3 == 0 ? value != NULL : !value || *value != (int)key)
+      mismatches++;
+  }
+  CHECK_INT(mismatches, 0);
+}
+
+static void test_ring() {
+  IntRing ring;
+  int value;
+
+  IntRing_init(&ring);
+  CHECK_INT(IntRing_pop(&ring, &value), -1);
+
+  // run the indices through several wraps, half full on average
+  int pushed = 0, popped = 0, bad = 0;
+  for (int step = 0; step < 1000; step++) {
+    if (step % 3 != 2) {
+      if (IntRing_push(&ring, &pushed) == 0)
+        pushed++;
+      else if (IntRing_count(&ring) != 8)
+        bad++;
+    }
+    else if (IntRing_pop(&ring, &value) == 0 && value != popped++) {
+      bad++;
+    }
+  }
+  CHECK_INT(bad, 0);
+  CHECK_INT(IntRing_count(&ring), pushed - popped);
+
+  // push_over keeps the newest elements
+  IntRing_init(&ring);
+  for (int i = 0; i < 20; i++)
+    IntRing_push_over(&ring, &i);
+  CHECK_INT(IntRing_count(&ring), 8);
+  CHECK_INT(*IntRing_at(&ring, 0), 12);
+  CHECK_INT(*IntRing_at(&ring, 7), 19);
+}
+
+static void test_heap() {
+  static IntHeap heap;
+  uint32_t state = 7;
+  int value, previous = -1, bad = 0;
+
+  IntHeap_init(&heap);
+  CHECK(IntHeap_peek(&heap) == NULL);
+  for (int i = 0; i < 512; i++) {
+    state = state * 1103515245 + 12345;
+    value = (state >> 16) % 1000;
+    IntHeap_push(&heap, &value);
+  }
+  CHECK_INT(IntHeap_push(&heap, &value), -1);
+
+  while (IntHeap_pop(&heap, &value) == 0) {
+    if (value < previous)
+      bad++;
+    previous = value;
+  }
+  CHECK_INT(bad, 0);
+  CHECK_INT(heap.count, 0);
+}
+
+static void test_list() {
+  ListNode head = LIST_HEAD_INIT(head);
+  Item items[4];
+  int order[4], n = 0;
+
+  CHECK(list_empty(&head));
+  for (int i = 0; i < 4; i++) {
+    items[i].value = i;
+    list_add_tail(&head, &items[i].node);
+  }
+  list_remove(&items[1].node);
+  list_add(&head, &items[1].node);
+
+  list_for_each(node, &head)
+    order[n++] = container_of(node, Item, node)->value;
+  CHECK_INT(n, 4);
+  CHECK_INT(order[0], 1);
+  CHECK_INT(order[1], 0);
+  CHECK_INT(order[2], 2);
+  CHECK_INT(order[3], 3);
+
+  list_for_each_safe(node, &head)
+    list_remove(node);
+  CHECK(list_empty(&head));
+}
+
+void test_containers() {
+  test_map();
+  test_ring();
+  test_heap();
+  test_list();
+}
@@ -0,0 +1,56 @@
+// -----------------------------------test_crc32.c -------------------------------------
+// kernel/crc32.c: check values, continuation and crc32_combine against one pass.
+// The three-stream instruction path only runs on aarch64 (make host_test_aarch64).
+
+#include "test.h"
+#include "kern.h"
+#include "../kernel/crc32.h"
+
+// One bit at a time, straight from the definition
+static uint32_t crc_bitwise(uint32_t poly, const uint8_t *p, size_t len) {
+  uint32_t crc = ~0u;
+
+  while (len--) {
+    crc ^= *p++;
+    for (int k = 0; k < 8; k++)
+      crc = (crc & 1) ? (crc >> 1) ^ poly : crc >> 1;
+  }
+  return ~crc;
+}
+
+void test_crc32() {
+  static uint8_t data[4 * CRC_STREAM_BYTES + 64];
+
+  crc32_init();
+  CHECK_INT(crc32(0, "123456789", 9), 0xCBF43926);
+  CHECK_INT(crc32c(0, "123456789", 9), 0xE3069283);
+  CHECK_INT(crc32(0, "", 0), 0);
+
+  for (size_t i = 0; i < sizeof(data); i++)
+    data[i] = (uint8_t)(i * 31 + (i >> 7));
+
+  static const size_t lengths[] = {1, 7, 8, 63, 3 * CRC_STREAM_BYTES - 1, 3 * CRC_STREAM_BYTES,
+                                   3 * CRC_STREAM_BYTES + 9, 4 * CRC_STREAM_BYTES};
+  for (int offset = 0; offset < 8; offset++) {
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+      size_t len = lengths[i];
+      CHECK_INT(crc32(0, data + offset, len), crc_bitwise(CRC32_POLY, data + offset, len));
+      CHECK_INT(crc32c(0, data + offset, len), crc_bitwise(CRC32C_POLY, data + offset, len));
+      CHECK_INT(crc32_table(0, data + offset, len), crc_bitwise(CRC32_POLY, data + offset, len));
+    }
+  }
+
+  // a running CRC over pieces matches one pass
+  uint32_t running = 0;
+  for (size_t at = 0; at < sizeof(data); at += 100)
+    running = crc32c(running, data + at, sizeof(data) - at < 100 ? sizeof(data) - at : 100);
+  CHECK_INT(running, crc32c(0, data, sizeof(data)));
+
+  // combining the CRCs of two pieces matches one pass over both
+  static const size_t splits[] = {0, 1, 5, 8, 100, CRC_STREAM_BYTES, 3 * CRC_STREAM_BYTES + 1, sizeof(data)};
+  for (size_t i = 0; i < sizeof(splits) / sizeof(splits[0]); i++) {
+    size_t at = splits[i], rest = sizeof(data) - at;
+    CHECK_INT(crc32_combine(crc32(0, data, at), crc32(0, data + at, rest), rest), crc32(0, data, sizeof(data)));
+    CHECK_INT(crc32c_combine(crc32c(0, data, at), crc32c(0, data + at, rest), rest), crc32c(0, data, sizeof(data)));
+  }
+}
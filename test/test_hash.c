@@ -0,0 +1,56 @@
+// -----------------------------------test_hash.c -------------------------------------
+// kernel/hash.c: alignment independence, every byte counted, seeds and mixing
+
+#include "test.h"
+#include "kern.h"
+#include "../kernel/hash.h"
+
+static int popcount64(uint64_t x) {
+  return __builtin_popcountll(x);
+}
+
+void test_hash() {
+  static uint8_t data[256 + 8];
+  static uint8_t moved[256 + 16];
+
+  for (size_t i = 0; i < sizeof(data); i++)
+    data[i] = (uint8_t)(i * 131 + (i >> 3));
+
+  // the same bytes hash the same from any address, across every length path
+  for (size_t len = 0; len <= 200; len++) {
+    uint64_t expected = hash_bytes(data, len, 7);
+    for (int offset = 1; offset < 8; offset++) {
+      memcpy(moved + offset, data, len);
+      CHECK_INT(hash_bytes(moved + offset, len, 7), expected);
+    }
+  }
+
+  // changing any single byte changes the hash
+  for (size_t len = 1; len <= 100; len += 3) {
+    uint64_t base = hash_bytes(data, len, 0);
+    for (size_t i = 0; i < len; i++) {
+      data[i] ^= 0x10;
+      CHECK(hash_bytes(data, len, 0) != base);
+      data[i] ^= 0x10;
+    }
+  }
+
+  // length and seed both count
+  CHECK(hash_bytes("a\0", 1, 0) != hash_bytes("a\0", 2, 0));
+  CHECK(hash_bytes("", 0, 0) != hash_bytes("", 0, 1));
+  CHECK(hash_bytes("help", 4, 0) != hash_bytes("help", 4, 1));
+  CHECK_INT(hash_str("setcolor"), hash_bytes("setcolor", 8, 0));
+  CHECK(hash_str("set_baud") != hash_str("set_fifo"));
+
+  // one flipped input bit flips about half of the output bits
+  long flips = 0, trials = 0;
+  for (uint64_t key = 1; key < 1000; key++) {
+    uint64_t base = hash_u64(key, 0);
+    for (int bit = 0; bit < 64; bit++) {
+      flips += popcount64(base ^ hash_u64(key ^ (1UL << bit), 0));
+      trials++;
+    }
+  }
+  CHECK(flips * 100 / trials > 3000 && flips * 100 / trials < 3400);
+  CHECK(hash_u64(42, 0) != hash_u64(42, 1));
+}
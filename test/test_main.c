@@ -0,0 +1,21 @@
+// -----------------------------------test_main.c -------------------------------------
+// Host unit tests for the kernel libraries (make host_test)
+
+#include "test.h"
+
+int testChecks = 0;
+int testFailures = 0;
+
+int main(void) {
+  test_string();
+  test_printf();
+  test_crc32();
+  test_hash();
+  test_containers();
+  test_page_alloc();
+  test_slab();
+  test_cli();
+
+  printf("%d checks, %d failed\n", testChecks, testFailures);
+  return testFailures ? 1 : 0;
+}
@@ -0,0 +1,81 @@
+// -----------------------------------test_page_alloc.c -------------------------------------
+// kernel/page_alloc.c: alignment, no overlap, splitting and merging back, bad frees
+
+#include "test.h"
+#include "kern.h"
+#include "../kernel/page_alloc.h"
+
+#define MAX_LIVE 512
+
+static TestBlock live[MAX_LIVE];
+static uint8_t *arena;
+static PageStats before;
+static int badBlocks;
+
+// Mostly orders 0-2, a quarter of the time any order; every block must be
+// aligned to its size, inside the managed range and report its order
+static void *alloc_pages(uint32_t random, size_t *len) {
+  unsigned int order = (random >> 20) % 4 == 0 ? (random >> 12) % PAGE_ORDERS : (random >> 12) % 3;
+  uint8_t *p = page_alloc(order);
+
+  *len = PAGE_SIZE << order;
+  if (p && (((uintptr_t)p - (uintptr_t)arena) % *len || (uintptr_t)p < before.start ||
+            (uintptr_t)p + *len > before.end || page_order(p) != (int)order))
+    badBlocks++;
+  return p;
+}
+
+void test_page_alloc() {
+  PageStats after;
+
+  arena = test_arena();
+
+  // start 3 pages into a 2MB block so the first block is ragged
+  uintptr_t start = (uintptr_t)arena + 3 * PAGE_SIZE + 100;
+  unsigned long pages = page_alloc_init(start, (uintptr_t)arena + TEST_ARENA_BYTES);
+  page_alloc_stats(&before);
+  CHECK_INT(pages, before.freePages);
+  CHECK(before.start >= start);
+  CHECK(pages > TEST_ARENA_BYTES / PAGE_SIZE - 16);
+
+  unsigned long freeBytes = 0;
+  for (unsigned int order = 0; order < PAGE_ORDERS; order++)
+    freeBytes += before.freeBlocks[order] * (PAGE_SIZE << order);
+  CHECK_INT(freeBytes, pages * PAGE_SIZE);
+
+  CHECK(page_alloc(PAGE_MAX_ORDER + 1) == NULL);
+
+  // random allocs and frees keep their fill
+  CHECK_INT(test_churn(live, MAX_LIVE, 20000, 3, alloc_pages, page_free), 0);
+  CHECK_INT(badBlocks, 0);
+
+  // everything freed merges back into the blocks it started as
+  test_churn_end(live, MAX_LIVE, page_free);
+  page_alloc_stats(&after);
+  CHECK_INT(after.freePages, before.freePages);
+  for (unsigned int order = 0; order < PAGE_ORDERS; order++)
+    CHECK_INT(after.freeBlocks[order], before.freeBlocks[order]);
+
+  // exhaust order 9, then smaller blocks still come from the ragged start
+  unsigned long big = 0;
+  while (page_alloc(PAGE_MAX_ORDER))
+    big++;
+  CHECK_INT(big, before.freeBlocks[PAGE_MAX_ORDER]);
+  page_alloc_stats(&after);
+  CHECK(after.failures > 0);
+  CHECK(page_alloc(0) != NULL);
+
+  // bad frees are reported and change nothing
+  mock_uart_take();
+  void *p = page_alloc(0);
+  page_free(p);
+  page_free(p);
+  page_free(arena);
+  page_free((uint8_t *)p + 8);
+  const char *log = mock_uart_take();
+  CHECK(strstr(log, "not an allocated block") != NULL);
+  CHECK(strstr(log, "not a managed page") != NULL);
+  CHECK_INT(page_order(p), -1);
+
+  free(arena);
+}
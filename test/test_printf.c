@@ -0,0 +1,127 @@
+// -----------------------------------test_printf.c -------------------------------------
+// cli/printf.c: conversions against the C library, truncation, the console
+// path through the mock UART and the pre-parsed formats
+
+#include "test.h"
+#include "kern.h"
+
+#include <stdarg.h>
+#include <stdlib.h>
+
+// Integer formats where the kernel printf and the C library agree
+static const char *intFormats[] = {"%d", "%5d", "%05d", "%.3d", "%8.3d", "%u", "%x", "%X", "%08x", "%o"};
+static const long intValues[] = {0, 1, -1, 42, -42, 2147483647, -2147483647 - 1, 65535};
+
+static void test_integers() {
+  char got[64], want[64];
+
+  for (size_t f = 0; f < sizeof(intFormats) / sizeof(intFormats[0]); f++) {
+    for (size_t v = 0; v < sizeof(intValues) / sizeof(intValues[0]); v++) {
+      int gotLen = kern_snprintf(got, sizeof(got), intFormats[f], (int)intValues[v]);
+      int wantLen = snprintf(want, sizeof(want), intFormats[f], (int)intValues[v]);
+      CHECK_STR(got, want);
+      CHECK_INT(gotLen, wantLen);
+    }
+  }
+
+  kern_snprintf(got, sizeof(got), "%lu %ld %lx", 18446744073709551615UL, -9223372036854775807L - 1, 0xFEDCBA9876543210UL);
+  CHECK_STR(got, "18446744073709551615 -9223372036854775808 fedcba9876543210");
+  kern_snprintf(got, sizeof(got), "%b %08b", 5u, 5u);
+  CHECK_STR(got, "101 00000101");
+}
+
+static void test_strings() {
+  char got[64];
+
+  // strings and characters pad on the right, the tables in cli/command.c rely on it
+  kern_snprintf(got, sizeof(got), "[%s|%8s|%.2s|%c|%3c|%%]", "abc", "left", "cut", 'x', 'y');
+  CHECK_STR(got, "[abc|left    |cu|x|y  |%]");
+
+  // output past the buffer is dropped, the return value is the full length
+  CHECK_INT(kern_snprintf(got, 6, "%s world", "hello"), 11);
+  CHECK_STR(got, "hello");
+  CHECK_INT(kern_snprintf(got, 1, "abc"), 3);
+  CHECK_STR(got, "");
+}
+
+static void test_floats() {
+  char got[64];
+
+  kern_snprintf(got, sizeof(got), "%f %.2f %.0f %e", 3.141592653589793, 1.005, 2.5, 6.02214076e23);
+  CHECK_STR(got, "3.141593 1.00 2 6.022141e+23");
+  kern_snprintf(got, sizeof(got), "%g %g %g %G", 0.0001, 100000.0, 1e-5, 1e20);
+  CHECK_STR(got, "0.0001 100000 1e-05 1E+20");
+  kern_snprintf(got, sizeof(got), "%.9g %8.3f %08.2f", 1.0 / 3.0, -2.5, -3.14159);
+  CHECK_STR(got, "0.333333333   -2.500 -0003.14");
+  kern_snprintf(got, sizeof(got), "%f %f %e", 1.0 / 0.0, -1.0 / 0.0, 0.0);
+  CHECK_STR(got, "inf -inf 0.000000e+00");
+
+  // shortest digits read back as the same double
+  static const double values[] = {0.1, 1.0 / 3.0, 5e-324, 1.7976931348623157e308, 123456.789, 9007199254740993.0};
+  for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+    char digits[DTOA_DIGITS_MAX + 1];
+    int exp10;
+    int count = dtoa_shortest(values[i], digits, &exp10);
+
+    snprintf(got, sizeof(got), "%.*se%d", count, digits, exp10);
+    CHECK(strtod(got, NULL) == values[i]);
+  }
+
+  // a precision rounds the exact binary value, not the shortest digits again
+  static const struct {
+    const char *format;
+    double value;
+  } exact[] = {
+    {"%.1f", 0.15}, {"%.1f", 0.35}, {"%.2f", 2.675}, {"%.3e", 5e-324}, {"%.20f", 0.1},
+    {"%f", 1e300}, {"%.17g", 0.1}, {"%.0f", 2.5}, {"%.0e", 1e23}, {"%g", 2.2250738585072014e-308},
+  };
+  for (size_t i = 0; i < sizeof(exact) / sizeof(exact[0]); i++) {
+    char big[400], want[400];
+
+    kern_snprintf(big, sizeof(big), exact[i].format, exact[i].value);
+    snprintf(want, sizeof(want), exact[i].format, exact[i].value);
+    CHECK_STR(big, want);
+  }
+}
+
+static void test_console() {
+  kern_printf("line %d\n", 1);
+  kern_printf("%s", "two");
+  CHECK_STR(mock_uart_take(), "line 1\ntwo");
+
+  PRINTF_FMT(UART_COUNTER, "bytes in", 42UL);
+  CHECK_STR(mock_uart_take(), "  bytes in       : 42\n");
+
+  char got[64];
+  SNPRINTF_FMT(got, sizeof(got), BENCH_LINE, 0x80000UL, -7, "ok", 3UL);
+  CHECK_STR(got, "00080000    -7 ok 3\n");
+}
+
+// Save the arguments the way aprintf does and print them later
+static int capture(FmtArg *args, char *strings, size_t size, const char *format, ...) {
+  va_list ap;
+  va_start(ap, format);
+  int count = fmt_capture(format, ap, args, 8, strings, size);
+  va_end(ap);
+  return count;
+}
+
+static void test_deferred() {
+  FmtArg args[8];
+  char strings[32];
+  char name[] = "uart0";
+
+  int count = capture(args, strings, sizeof(strings), "%s sent %lu bytes, %.1f%% idle", name, 1024UL, 12.5);
+  name[0] = 'X';  // the captured copy must not change
+  CHECK_INT(count, 3);
+  printf_args("%s sent %lu bytes, %.1f%% idle", args, count);
+  CHECK_STR(mock_uart_take(), "uart0 sent 1024 bytes, 12.5% idle");
+}
+
+void test_printf() {
+  test_integers();
+  test_strings();
+  test_floats();
+  test_console();
+  test_deferred();
+}
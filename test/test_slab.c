@@ -0,0 +1,83 @@
+// -----------------------------------test_slab.c -------------------------------------
+// kernel/slab.c: size classes and alignment, no overlap, magazines flushing, large blocks
+
+#include "test.h"
+#include "kern.h"
+#include "../kernel/slab.h"
+
+#define MAX_LIVE 2048
+
+static TestBlock live[MAX_LIVE];
+static int failedAllocs;
+
+// Mostly small objects, one in 64 up to 20000 bytes so large blocks show up too
+static void *alloc_object(uint32_t random, size_t *len) {
+  *len = (random >> 20) % 64 == 0 ? 1 + (random >> 4) % 20000 : 1 + (random >> 12) % 300;
+  void *p = kmalloc(*len);
+  if (!p)
+    failedAllocs++;
+  return p;
+}
+
+static unsigned long slabs_held(const SlabStats *stats) {
+  unsigned long slabs = 0;
+  for (unsigned int i = 0; i < SLAB_CLASSES; i++)
+    slabs += stats->classes[i].slabs;
+  return slabs;
+}
+
+void test_slab() {
+  uint8_t *arena = test_arena();
+  PageStats pagesBefore, pagesAfter;
+  SlabStats stats;
+
+  page_alloc_init((uintptr_t)arena, (uintptr_t)arena + TEST_ARENA_BYTES);
+  slab_init();
+  page_alloc_stats(&pagesBefore);
+
+  CHECK(kmalloc(0) == NULL);
+  kfree(NULL);
+
+  // each class's objects are aligned to their size, up to a cache line
+  static const size_t sizes[] = {1, 16, 17, 33, 64, 100, 500, 1024, 2048, 2049, 4096, 100000};
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    size_t align = sizes[i] > SLAB_MAX_SIZE ? PAGE_SIZE : sizes[i] < 64 ? 16 : 64;
+    uint8_t *p = kmalloc(sizes[i]);
+    CHECK(p != NULL);
+    CHECK_INT((uintptr_t)p % align, 0);
+    kfree(p);
+  }
+
+  // random sizes, each object keeps its fill until freed
+  CHECK_INT(test_churn(live, MAX_LIVE, 100000, 11, alloc_object, kfree), 0);
+  CHECK_INT(failedAllocs, 0);
+  test_churn_end(live, MAX_LIVE, kfree);
+
+  // nothing is in use; slabs stay only as the last partial one or for magazine objects
+  slab_stats(&stats);
+  unsigned long allocs = stats.largeAllocs, frees = stats.largeFrees;
+  for (unsigned int i = 0; i < SLAB_CLASSES; i++) {
+    SlabClassStats *c = &stats.classes[i];
+    CHECK_INT(c->objects - c->free - c->cached, 0);
+    CHECK(c->slabs <= 1 + c->cached);
+    CHECK(c->cached <= SLAB_MAGAZINE);
+    allocs += c->allocs;
+    frees += c->frees;
+  }
+  CHECK_INT(allocs, frees);
+  CHECK_INT(stats.largeBlocks, 0);
+  CHECK_INT(stats.largePages, 0);
+  page_alloc_stats(&pagesAfter);
+  CHECK_INT(pagesAfter.freePages + slabs_held(&stats) * (1UL << SLAB_ORDER), pagesBefore.freePages);
+
+  // too large for the biggest block, and a pointer that never came from kmalloc
+  CHECK(kmalloc((PAGE_SIZE << PAGE_MAX_ORDER) + 1) == NULL);
+  slab_stats(&stats);
+  CHECK_INT(stats.failures, 1);
+  mock_uart_take();
+  static uint8_t elsewhere[64] __attribute__((aligned(16384)));
+  kfree(elsewhere + 16);
+  CHECK(strstr(mock_uart_take(), "not from kmalloc") != NULL);
+
+  free(arena);
+}
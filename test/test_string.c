@@ -0,0 +1,241 @@
+// -----------------------------------test_string.c -------------------------------------
+// kernel/string.c against the C library, at every alignment the vector and
+// word paths care about
+
+#define _GNU_SOURCE  // memmem
+#include "test.h"
+#include "kern.h"
+
+#define SPAN 300
+
+static int sign(int x) {
+  return (x > 0) - (x < 0);
+}
+
+static void test_strlen_strchr() {
+  static char buffer[SPAN + 64] __attribute__((aligned(16)));
+
+  for (int offset = 0; offset < 16; offset++) {
+    for (int len = 0; len < SPAN; len += (len < 40 ? 1 : 37)) {
+      char *s = buffer + offset;
+      for (int i = 0; i < len; i++) {
+        s[i] = 'a' + i % 26;
+      }
+      s[len] = '\0';
+
+      CHECK_INT(kern_strlen(s), len);
+      CHECK_INT(strlen_scalar(s), len);
+      CHECK(kern_strchr(s, 'z') == strchr(s, 'z'));
+      CHECK(kern_strchr(s, 'a' + len % 26) == strchr(s, 'a' + len % 26));
+      CHECK(kern_strchr(s, '\0') == s + len);
+      CHECK(kern_strchr(s, '#') == NULL);
+      CHECK(strchr_scalar(s, 'c') == strchr(s, 'c'));
+    }
+  }
+}
+
+static void test_strcmp() {
+  static char a[SPAN + 64] __attribute__((aligned(16)));
+  static char b[SPAN + 64] __attribute__((aligned(16)));
+  static const int offsets[][2] = {{0, 0}, {3, 3}, {0, 5}, {7, 2}, {15, 15}};
+
+  for (size_t k = 0; k < sizeof(offsets) / sizeof(offsets[0]); k++) {
+    char *s1 = a + offsets[k][0];
+    char *s2 = b + offsets[k][1];
+
+    for (int len = 0; len < 100; len++) {
+      for (int i = 0; i < len; i++) {
+        s1[i] = s2[i] = 'A' + i % 50;
+      }
+      s1[len] = s2[len] = '\0';
+      CHECK_INT(kern_strcmp(s1, s2), 0);
+
+      if (len) {
+        s2[len - 1] = (char)0xE9;  // above 0x7F, compares as unsigned
+        CHECK_INT(sign(kern_strcmp(s1, s2)), sign(strcmp(s1, s2)));
+        CHECK_INT(sign(kern_strcmp(s2, s1)), sign(strcmp(s2, s1)));
+        CHECK_INT(sign(strcmp_scalar(s1, s2)), sign(strcmp(s1, s2)));
+      }
+      s2[len] = 'x';
+      s2[len + 1] = '\0';
+      CHECK(kern_strcmp(s1, s2) < 0);
+    }
+  }
+}
+
+static void test_copy() {
+  static unsigned char src[SPAN + 64], dest[SPAN + 64], expect[SPAN + 64];
+
+  for (int i = 0; i < SPAN + 64; i++) {
+    src[i] = (unsigned char)(i * 7 + 1);
+  }
+
+  for (int so = 0; so < 16; so++) {
+    for (int doff = 0; doff < 16; doff++) {
+      for (int n = 0; n < SPAN; n += (n < 70 ? 1 : 23)) {
+        memset(dest, 0xCC, sizeof(dest));
+        memset(expect, 0xCC, sizeof(expect));
+        memcpy(expect + doff, src + so, n);
+        CHECK(kern_memcpy(dest + doff, src + so, n) == dest + doff);
+        CHECK(memcmp(dest, expect, sizeof(dest)) == 0);
+
+        memset(expect, 0xCC, sizeof(expect));
+        memset(expect + doff, so, n);
+        kern_memset(dest, 0xCC, sizeof(dest));
+        kern_memset(dest + doff, so, n);
+        CHECK(memcmp(dest, expect, sizeof(dest)) == 0);
+      }
+    }
+  }
+}
+
+// Zero fills of a few blocks go through DC ZVA where the CPU offers it
+static void test_zero_fill() {
+  static unsigned char buffer[4096 + 256] __attribute__((aligned(64)));
+
+  for (size_t offset = 0; offset < 80; offset += 7) {
+    for (size_t n = 256; n < 4096; n += 509) {
+      int bad = 0;
+
+      kern_memset(buffer, 0xA5, sizeof(buffer));
+      kern_memset(buffer + offset, 0, n);
+      for (size_t i = 0; i < sizeof(buffer); i++) {
+        bad += buffer[i] != ((i >= offset && i < offset + n) ? 0 : 0xA5);
+      }
+      CHECK_INT(bad, 0);
+    }
+  }
+}
+
+static void test_memmove() {
+  static unsigned char buffer[SPAN + 64], expect[SPAN + 64];
+
+  for (int d = 0; d < 24; d++) {
+    for (int s = 0; s < 24; s++) {
+      for (int n = 0; n < 200; n += 7) {
+        for (int i = 0; i < SPAN + 64; i++) {
+          buffer[i] = expect[i] = (unsigned char)(i * 13 + 5);
+        }
+        memmove(expect + d, expect + s, n);
+        CHECK(kern_memmove(buffer + d, buffer + s, n) == buffer + d);
+        CHECK(memcmp(buffer, expect, sizeof(buffer)) == 0);
+      }
+    }
+  }
+}
+
+static void test_memcmp() {
+  static unsigned char a[128], b[128];
+
+  for (int i = 0; i < 128; i++) {
+    a[i] = b[i] = (unsigned char)i;
+  }
+  for (int offset = 0; offset < 8; offset++) {
+    for (int n = 0; n < 100; n++) {
+      CHECK_INT(kern_memcmp(a + offset, b + offset, n), 0);
+      if (n) {
+        b[offset + n - 1] ^= 0x80;
+        CHECK_INT(sign(kern_memcmp(a + offset, b + offset, n)), sign(memcmp(a + offset, b + offset, n)));
+        CHECK_INT(sign(kern_memcmp(a, b + offset, n)), sign(memcmp(a, b + offset, n)));
+        b[offset + n - 1] ^= 0x80;
+      }
+    }
+  }
+}
+
+static void test_search() {
+  static const char text[] =
+    "[INFO kernel] boot 3\n[WARN mbox] Mailbox call failed\n[INFO uart] uart0 rx 115200\n";
+  static const char *needles[] = {"", "[", "b", "boot", "Mailbox call", "failed\n[INFO", "115200\n",
+                                  "uart1", "[INFO uart] uart0 rx 115200\n", "Mailbox call fails"};
+
+  for (size_t i = 0; i < sizeof(needles) / sizeof(needles[0]); i++) {
+    CHECK(kern_strstr(text, needles[i]) == strstr(text, needles[i]));
+    CHECK(strstr_scalar(text, needles[i]) == strstr(text, needles[i]));
+    CHECK(kern_memmem(text, sizeof(text) - 1, needles[i], strlen(needles[i])) ==
+          memmem(text, sizeof(text) - 1, needles[i], strlen(needles[i])));
+  }
+
+  // periodic needles in repetitive haystacks, long enough for strstr to read
+  // its haystack in several chunks
+  static char runs[3000];
+  static const char *repeats[] = {"aaaab", "aab", "abab", "ababa", "aaaaaaaaab", "baaaaaaaaa", "abaabaab"};
+  for (size_t i = 0; i < sizeof(repeats) / sizeof(repeats[0]); i++) {
+    for (size_t at = 0; at + 16 < sizeof(runs); at += 997) {
+      memset(runs, 'a', sizeof(runs) - 1);
+      for (size_t j = 1; j < sizeof(runs) - 1; j += 3)
+        runs[j] = i & 1 ? 'b' : 'a';
+      memcpy(runs + at, repeats[i], strlen(repeats[i]));
+      CHECK(kern_strstr(runs, repeats[i]) == strstr(runs, repeats[i]));
+      CHECK(kern_memmem(runs, sizeof(runs) - 1, repeats[i], strlen(repeats[i])) ==
+            memmem(runs, sizeof(runs) - 1, repeats[i], strlen(repeats[i])));
+    }
+  }
+
+  // a window that ends one byte short of the match
+  CHECK(kern_memmem(text, 19, "boot 3", 6) == NULL);
+  CHECK(kern_memmem(text, 20, "boot 3", 6) == text + 14);
+
+  for (size_t n = 0; n < sizeof(text); n++) {
+    CHECK(kern_memchr(text, '\n', n) == memchr(text, '\n', n));
+    CHECK(kern_memchr(text + 3, '~', n > 3 ? n - 3 : 0) == NULL);
+  }
+}
+
+static void test_tokens() {
+  char line[] = "  setcolor -t  green -b yellow  ";
+  char *argv[8];
+
+  CHECK_INT(strsplit(line, " ", argv, 8), 5);
+  CHECK_STR(argv[0], "setcolor");
+  CHECK_STR(argv[2], "green");
+  CHECK_STR(argv[4], "yellow");
+
+  char blank[] = "   ";
+  CHECK_INT(strsplit(blank, " ", argv, 8), 0);
+
+  char many[] = "a b c d";
+  CHECK_INT(strsplit(many, " ", argv, 3), -1);
+
+  // no empty token after a trailing delimiter, and two cursors at once
+  char outer[] = "a=1,b=2,";
+  char inner[8];
+  char *save1, *save2;
+  int count = 0;
+  for (char *pair = kern_strtok_r(outer, ",", &save1); pair; pair = kern_strtok_r(NULL, ",", &save1)) {
+    strcpy(inner, pair);
+    CHECK_STR(kern_strtok_r(inner, "=", &save2), count ? "b" : "a");
+    CHECK_STR(kern_strtok_r(NULL, "=", &save2), count ? "2" : "1");
+    CHECK(kern_strtok_r(NULL, "=", &save2) == NULL);
+    count++;
+  }
+  CHECK_INT(count, 2);
+}
+
+static void test_strtoul() {
+  char *end;
+
+  CHECK_INT(kern_strtoul("115200", &end, 10), 115200);
+  CHECK_INT(*end, '\0');
+  CHECK_INT(kern_strtoul("ff", NULL, 16), 255);
+  CHECK_INT(kern_strtoul("FF", NULL, 16), 255);
+
+  // digits past the base end the number
+  CHECK_INT(kern_strtoul("12x", &end, 10), 12);
+  CHECK_STR(end, "x");
+  CHECK_INT(kern_strtoul("19", &end, 8), 1);
+  CHECK_STR(end, "9");
+  CHECK_INT(kern_strtoul("", &end, 10), 0);
+}
+
+void test_string() {
+  test_strlen_strchr();
+  test_strcmp();
+  test_copy();
+  test_zero_fill();
+  test_memmove();
+  test_memcmp();
+  test_search();
+  test_tokens();
+  test_strtoul();
+}
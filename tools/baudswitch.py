@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+# -----------------------------------baudswitch.py -------------------------------------
+# Host side of the switch_baud handshake.
+# Usage: python3 tools/baudswitch.py /dev/ttyUSB0 921600
+# Requires pyserial (pip install pyserial)
+
+import sys
+import time
+import serial
+
+DEFAULT_BAUD = 115200
+PROBE = bytes([0x55, 0xAA, 0x0F, 0xF0]) + b"PROBE"
+TIMEOUT = 1.0
+
+
+def read_line_containing(port, keys, timeout):
+    deadline = time.time() + timeout
+    buf = b""
+    while time.time() < deadline:
+        buf += port.read(port.in_waiting or 1)
+        for key in keys:
+            if key in buf:
+                return key
+    return None
+
+
+def switch(device, rate):
+    port = serial.Serial(device, DEFAULT_BAUD, timeout=0.1)
+    port.reset_input_buffer()
+    port.write(b"switch_baud %d\r" % rate)
+
+    reply = read_line_containing(port, [b"ACK %d" % rate, b"NAK"], TIMEOUT)
+    if reply != b"ACK %d" % rate:
+        print("board refused %d baud" % rate)
+        return False
+
+    # give the board time to drain its FIFO and reprogram the divisors
+    time.sleep(0.05)
+    port.baudrate = rate
+    port.reset_input_buffer()
+    port.write(PROBE)
+
+    if read_line_containing(port, [PROBE], TIMEOUT) is None:
+        port.baudrate = DEFAULT_BAUD
+        print("no probe echo, staying at %d baud" % DEFAULT_BAUD)
+        return False
+
+    port.write(b"OK")
+    print("switched to %d baud" % rate)
+    return True
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 3:
+        print("usage: %s <device> <baud>" % sys.argv[0])
+        sys.exit(2)
+    sys.exit(0 if switch(sys.argv[1], int(sys.argv[2])) else 1)
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+# -----------------------------------dlog_decode.py -------------------------------------
+# Decode the deferred binary log stream (DLOG) back to text.
+# The format strings come from build/dlog.bin, extracted from the ELF by the Makefile.
+#
+# Usage:
+#   python3 tools/dlog_decode.py build/dlog.bin capture.bin
+#   python3 tools/dlog_decode.py build/dlog.bin /dev/pts/3 --serial [--baud 115200]
+#   (--serial needs pyserial)
+
+import argparse
+import math
+import re
+import struct
+import sys
+
+DLOG_SYNC = 0xDF
+CONVERSION = re.compile(rb"%([-+ #0]*)(\*|[0-9]*)(?:\.(\*|[0-9]*))?([hlzjtqL]*)([diuxXobpcsfFeEgGaAn%])")
+
+
+def load_table(path):
+    with open(path, "rb") as f:
+        return f.read()
+
+
+def format_at(table, offset):
+    if offset >= len(table):
+        return None
+    end = table.find(b"\0", offset)
+    return table[offset:end if end >= 0 else len(table)]
+
+
+class Stream:
+    def __init__(self, source):
+        self.source = source
+
+    def byte(self):
+        b = self.source.read(1)
+        if not b:
+            raise EOFError
+        return b[0]
+
+    def varint(self):
+        value, shift = 0, 0
+        while True:
+            b = self.byte()
+            value |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                return value
+
+
+def quad(raw):
+    """IEEE binary128 (an AArch64 long double) to the nearest Python float"""
+    bits = int.from_bytes(raw, "little")
+    sign = -1.0 if bits >> 127 else 1.0
+    exponent = (bits >> 112) & 0x7FFF
+    mantissa = bits & ((1 << 112) - 1)
+    if exponent == 0x7FFF:
+        return sign * math.inf if not mantissa else math.nan
+    if exponent == 0:
+        return sign * math.ldexp(mantissa, -16382 - 112)
+    try:
+        return sign * math.ldexp(mantissa | 1 << 112, exponent - 16383 - 112)
+    except OverflowError:
+        return sign * math.inf
+
+
+def zigzag(v):
+    return (v >> 1) ^ -(v & 1)
+
+
+def render(fmt, stream):
+    out = []
+    pos = 0
+    for m in CONVERSION.finditer(fmt):
+        out.append(fmt[pos:m.start()].decode(errors="replace"))
+        pos = m.end()
+        flags, width, precision, length, conv = (g.decode() if g is not None else None for g in m.groups())
+
+        if conv == "%":
+            out.append("%")
+            continue
+        # a '*' width or precision was queued ahead of the value
+        if width == "*":
+            width = zigzag(stream.varint())
+            if width < 0:
+                flags, width = flags + "-", -width
+            width = str(width)
+        if precision == "*":
+            precision = zigzag(stream.varint())
+            precision = str(precision) if precision >= 0 else None
+        spec = "%" + flags + width + ("." + precision if precision is not None else "")
+
+        if conv == "n":
+            pass
+        elif conv in "di":
+            out.append((spec + "d") % zigzag(stream.varint()))
+        elif conv in "uxXo":
+            out.append((spec + {"u": "d"}.get(conv, conv)) % stream.varint())
+        elif conv == "b":
+            fill = "0" if "0" in flags and "-" not in flags else ""
+            out.append(format(stream.varint(), ("<" if "-" in flags else "") + fill + width + "b"))
+        elif conv == "p":
+            out.append("0x%x" % stream.varint())
+        elif conv in "fFeEgGaA":
+            if "L" in length:
+                value = quad(bytes(stream.byte() for _ in range(16)))
+            else:
+                value = struct.unpack("<d", bytes(stream.byte() for _ in range(8)))[0]
+            if conv in "aA":
+                text = value.hex()
+                out.append(("%" + flags + width + "s") % (text.upper() if conv == "A" else text))
+            else:
+                out.append((spec + conv) % value)
+        elif conv == "c":
+            out.append(("%" + flags + width + "c") % chr(stream.byte()))
+        elif conv == "s":
+            n = stream.varint()
+            out.append((spec + "s") % bytes(stream.byte() for _ in range(n)).decode(errors="replace"))
+    out.append(fmt[pos:].decode(errors="replace"))
+    return "".join(out)
+
+
+def decode(table, source, tick_hz):
+    stream = Stream(source)
+    ticks = 0
+    try:
+        while True:
+            if stream.byte() != DLOG_SYNC:
+                continue  # resynchronise on the next frame
+            fmt = format_at(table, stream.varint())
+            ticks += stream.varint()
+            if fmt is None:
+                print("<unknown id>", file=sys.stderr)
+                continue
+            print("[%12.6f] %s" % (ticks / tick_hz, render(fmt, stream)), flush=True)
+    except EOFError:
+        pass
+
+
+if __name__ == "__main__":
+    ap = argparse.ArgumentParser(description="Decode DLOG binary log records")
+    ap.add_argument("table", help="build/dlog.bin")
+    ap.add_argument("input", help="capture file or serial device")
+    ap.add_argument("--serial", action="store_true", help="input is a serial device")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--tick-hz", type=float, default=62.5e6,
+                    help="system counter frequency (62.5MHz in QEMU, 19.2MHz on the board)")
+    args = ap.parse_args()
+
+    table = load_table(args.table)
+    if args.serial:
+        import serial
+        source = serial.Serial(args.input, args.baud)
+    else:
+        source = open(args.input, "rb")
+    decode(table, source, args.tick_hz)
@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+# -----------------------------------flowtest.py -------------------------------------
+# Checks that the board throttles a host that keeps sending while it is busy.
+# Streams input while "help" prints, then reads the PL011 counters back: the
+# "host throttled" count has to go up and "overruns" has to stay at 0.
+# Usage: python3 tools/flowtest.py /dev/ttyUSB0 [on|xonxoff] [bytes]
+# Requires pyserial (pip install pyserial)
+
+import re
+import sys
+import time
+import serial
+
+DEFAULT_BAUD = 115200
+TIMEOUT = 2.0
+# DEL with an empty command line: read and dropped by the shell, nothing echoed
+FILLER = b"\x7f"
+
+
+def read_until(port, key, timeout):
+    deadline = time.time() + timeout
+    buf = b""
+    while time.time() < deadline:
+        buf += port.read(port.in_waiting or 1)
+        if key in buf:
+            return buf
+    return buf
+
+
+def pl011_counters(port):
+    port.write(b"uartstat\r")
+    text = read_until(port, b"Port 1", TIMEOUT).decode("ascii", "replace")
+    pl011 = text.split("Port 0", 1)[-1]
+    counters = {}
+    for name in ("overruns", "host throttled"):
+        match = re.search(r"%s:\s*(\d+)" % name, pl011)
+        counters[name] = int(match.group(1)) if match else None
+    return counters
+
+
+def run(device, mode, count):
+    port = serial.Serial(device, DEFAULT_BAUD, timeout=0.1)
+    port.reset_input_buffer()
+    port.write(b"set_handshaking %s\r" % mode.encode())
+    read_until(port, b"MyBareOS>", TIMEOUT)
+    port.rtscts = mode == "on"
+    port.xonxoff = mode == "xonxoff"
+
+    port.write(b"uartstat reset\r")
+    read_until(port, b"reset", TIMEOUT)
+
+    # the board services its receiver while "help" prints, so the ring fills
+    port.write(b"help\r" + FILLER * count + b"\r")
+    time.sleep(count * 10.0 / DEFAULT_BAUD + 1.0)
+    port.reset_input_buffer()
+
+    counters = pl011_counters(port)
+    port.write(b"set_handshaking off\r")
+    print("throttled %s, overruns %s" % (counters["host throttled"], counters["overruns"]))
+
+    if counters["host throttled"] is None or counters["overruns"] is None:
+        print("no uartstat output")
+        return False
+    return counters["host throttled"] > 0 and counters["overruns"] == 0
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2 or len(sys.argv) > 4:
+        print("usage: %s <device> [on|xonxoff] [bytes]" % sys.argv[0])
+        sys.exit(2)
+    mode = sys.argv[2] if len(sys.argv) > 2 else "on"
+    count = int(sys.argv[3]) if len(sys.argv) > 3 else 4096
+    sys.exit(0 if run(sys.argv[1], mode, count) else 1)
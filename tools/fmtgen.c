@@ -0,0 +1,57 @@
+// -----------------------------------fmtgen.c -------------------------------------
+// Host tool: parse every format in cli/formats.h ahead of time and print the
+// FmtProgram tables as C. Run by the Makefile (fmt_build), output goes to
+// build/fmt_gen.c.
+//
+// Usage: ./build/fmtgen > ./build/fmt_gen.c
+
+#include <stdio.h>
+#include "../cli/fmtparse.h"
+#include "../cli/formats.h"
+
+#define MAX_SPECS 64
+
+typedef struct {
+  const char *id;
+  const char *text;
+} FormatEntry;
+
+#define FMT_ENTRY(id) {#id, FMT_##id},
+static const FormatEntry formats[] = {
+  FORMAT_LIST(FMT_ENTRY)
+};
+
+static void print_conv(char conv) {
+  if (conv >= ' ' && conv <= '~' && conv != '\'' && conv != '\\') {
+    printf("'%c'", conv);
+  }
+  else {
+    printf("%d", conv);
+  }
+}
+
+int main(void) {
+  FmtSpec specs[MAX_SPECS];
+
+  printf("/* Generated by tools/fmtgen from cli/formats.h, do not edit */\n");
+  printf("#include \"../cli/printf.h\"\n");
+
+  for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+    int count = fmt_compile(formats[i].text, specs, MAX_SPECS);
+    if (count < 0) {
+      fprintf(stderr, "fmtgen: FMT_%s has more than %d conversions\n", formats[i].id, MAX_SPECS);
+      return 1;
+    }
+
+    printf("\nstatic const FmtSpec fmtSpecs_%s[] = {\n", formats[i].id);
+    for (int n = 0; n < count; n++) {
+      printf("  {%u, %u, ", specs[n].literal, specs[n].skip);
+      print_conv(specs[n].conv);
+      printf(", %u, %u, %d, %d},\n", specs[n].zeroPad, specs[n].length, specs[n].width, specs[n].precision);
+    }
+    printf("};\n");
+    printf("const FmtProgram fmtProgram_%s = {FMT_%s, fmtSpecs_%s, %d};\n",
+           formats[i].id, formats[i].id, formats[i].id, count);
+  }
+  return 0;
+}
@@ -0,0 +1,235 @@
+#include "uart.h"
+#include "uart0.h"
+#include "uart1.h"
+#include "../kernel/console.h"
+#include "../kernel/cpu.h"
+#include "../kernel/string.h"
+
+// Both backends are linked in, indexed by port number
+const UartDriver *uartPorts[UART_PORT_COUNT] = {
+  &uart0_driver,
+  &uart1_driver,
+};
+
+static const UartDriver *console = 0;
+static int consolePort = CONSOLE_UART;
+static int logPort = CONSOLE_UART == UART_PORT_PL011 ? UART_PORT_MINI : UART_PORT_PL011;
+
+/**
+ * Initialize both ports, the console port is mapped to GPIO14/15
+ */
+void uart_init() {
+  for (int i = 0; i < UART_PORT_COUNT; i++) {
+    uartPorts[i]->init(i == consolePort);
+  }
+  console = uartPorts[consolePort];
+}
+
+int uart_select_console(int port) {
+  if (port < 0 || port >= UART_PORT_COUNT)
+    return 0;
+
+  console_sync();
+  console->flush();
+  consolePort = port;
+  console = uartPorts[port];
+  return 1;
+}
+
+int uart_select_log(int port) {
+  if (port < 0 || port >= UART_PORT_COUNT)
+    return 0;
+
+  uartPorts[logPort]->flush();
+  logPort = port;
+  return 1;
+}
+
+int uart_console_port() {
+  return consolePort;
+}
+
+int uart_log_port() {
+  return logPort;
+}
+
+void uart_reset_stats(int port) {
+  UartStats *stats = uartPorts[port]->stats;
+  UartStats zero = {0};
+
+  *stats = zero;
+}
+
+// 1 while another core (the I/O core) owns the console and writes the UART
+static int console_elsewhere() {
+  return console_owner() != cpu_id();
+}
+
+/**
+ * Send a character, through the console lane while another core owns the console
+ */
+void uart_sendc(char c) {
+  if (console_elsewhere()) {
+    console_write(&c, 1);
+    return;
+  }
+  console->sendc(c);
+}
+
+/**
+ * Receive a character
+ */
+char uart_getc() {
+  return console->getc();
+}
+
+/**
+ * Display a string on a port
+ */
+void uart_port_puts(int port, char *s) {
+  const UartDriver *uart = uartPorts[port];
+
+  while (*s) {
+    /* convert newline to carriage return + newline */
+    if (*s == '\n')
+      uart->sendc('\r');
+    uart->sendc(*s++);
+  }
+}
+
+/**
+ * Write len bytes to the console, used by the printf sink
+ */
+void uart_write(const char *s, size_t len) {
+  while (len--) {
+    /* convert newline to carriage return + newline */
+    if (*s == '\n')
+      console->sendc('\r');
+    console->sendc(*s++);
+  }
+}
+
+/**
+ * Display a string, through the console lane while another core owns the console
+ */
+void uart_puts(char *s) {
+  if (console_elsewhere()) {
+    console_write(s, strlen(s));
+    return;
+  }
+  uart_port_puts(consolePort, s);
+}
+
+/**
+ * Display a string on the log/trace port
+ */
+void uart_log_puts(char *s) {
+  uart_port_puts(logPort, s);
+}
+
+/**
+* Display a value in hexadecimal format
+*/
+void uart_hex(unsigned int num) {
+	uart_puts("0x");
+	for (int pos = 28; pos >= 0; pos = pos - 4) {
+
+		// Get highest 4-bit nibble
+		char digit = (num >> pos) & 0xF;
+
+		/* Convert to ASCII code */
+		// 0-9 => '0'-'9', 10-15 => 'A'-'F'
+		digit += (digit > 9) ? (-10 + 'A') : '0';
+		uart_sendc(digit);
+	}
+}
+
+/*
+**
+* Display a value in decimal format
+*/
+void uart_dec(int num)
+{
+	//A string to store the digit characters
+	char str[33] = "";
+
+	//Calculate the number of digits
+	int len = 1;
+	int temp = num;
+	while (temp >= 10){
+		len++;
+		temp = temp / 10;
+	}
+
+	//Store into the string and print out
+	for (int i = 0; i < len; i++){
+		int digit = num % 10; //get last digit
+		num = num / 10; //remove last digit from the number
+		str[len - (i + 1)] = digit + '0';
+	}
+	str[len] = '\0';
+
+	uart_puts(str);
+}
+
+void uart_flush() {
+  console->flush();
+}
+
+/**
+ * Service the console port's receiver, for loops that wait on another core
+ */
+void uart_poll() {
+  if (console->poll)
+    console->poll();
+}
+
+int uart_getc_timeout(char *c, unsigned int msec) {
+  return console->getc_timeout(c, msec);
+}
+
+// Line settings change once everything printed so far has gone out. A
+// backend without a setter only accepts the setting it already has.
+int uart_set_baud_rate(unsigned int baud_rate) {
+  if (!console->set_baud_rate)
+    return baud_rate == console->get_baud_rate();
+  console_sync();
+  return console->set_baud_rate(baud_rate);
+}
+
+/**
+ * 1 if the console port's backend can generate baud_rate
+ */
+int uart_baud_supported(unsigned int baud_rate) {
+  return baud_rate >= console->baud_min && baud_rate <= console->baud_max;
+}
+
+unsigned int uart_get_baud_rate() {
+  return console->get_baud_rate();
+}
+
+int uart_set_data_bits(unsigned char data_bits) {
+  if (!console->set_data_bits)
+    return 0;
+  console_sync();
+  return console->set_data_bits(data_bits);
+}
+
+int uart_set_stop_bits(unsigned char stop_bits) {
+  if (!console->set_stop_bits)
+    return 0;
+  console_sync();
+  return console->set_stop_bits(stop_bits);
+}
+
+int uart_set_parity(char *parity) {
+  if (!console->set_parity)
+    return 0;
+  console_sync();
+  return console->set_parity(parity);
+}
+
+int uart_set_flow_control(int mode) {
+  console_sync();
+  return console->set_flow_control(mode);
+}
@@ -0,0 +1,96 @@
+#ifndef UART_H
+#define UART_H
+
+#include "../gcclib/stddef.h"
+
+#define UART_BAUD_DEFAULT 115200
+
+/* Flow control modes */
+#define UART_FLOW_NONE    0
+#define UART_FLOW_RTSCTS  1
+#define UART_FLOW_XONXOFF 2
+
+#define UART_XON  0x11
+#define UART_XOFF 0x13
+
+/* Serial port numbers, in the order QEMU assigns -serial options on raspi3b */
+#define UART_PORT_PL011 0
+#define UART_PORT_MINI  1
+#define UART_PORT_COUNT 2
+
+/* Port used for the console when the kernel boots (overridden by the Makefile targets) */
+#ifndef CONSOLE_UART
+#define CONSOLE_UART UART_PORT_PL011
+#endif
+
+/* Per-port counters */
+typedef struct {
+  unsigned long rx_bytes;
+  unsigned long tx_bytes;
+  unsigned long rx_polls; // polls that found the RX level or receive timeout raised
+  unsigned long tx_waits; // sends that waited on a full TX FIFO for the TX level
+  unsigned long overruns;
+  unsigned long framing_errors;
+  unsigned long parity_errors;
+  unsigned long break_errors;
+  unsigned long tx_stall_ticks; // timer ticks spent waiting for TX FIFO space
+  unsigned long rx_peak;        // highest receive ring occupancy
+  unsigned long throttles;      // times the host was stopped at the high watermark
+  unsigned long remote_pauses;  // XOFF received from the host
+} UartStats;
+
+/* Operations of a UART backend. The setters return 1, or 0 if the hardware
+   can't apply the setting; a backend leaves the ones it has no control over NULL */
+typedef struct {
+  const char *name;
+  void (*init)(int primary);
+  void (*sendc)(char c);
+  char (*getc)();
+  int (*getc_timeout)(char *c, unsigned int msec);
+  void (*flush)();
+  void (*poll)();          // move received bytes into the RX ring, NULL without one
+  int (*set_baud_rate)(unsigned int baud_rate);
+  unsigned int baud_min;   // range set_baud_rate can generate, the fixed rate without it
+  unsigned int baud_max;
+  unsigned int (*get_baud_rate)();
+  int (*set_data_bits)(unsigned char data_bits);
+  int (*set_stop_bits)(unsigned char stop_bits);
+  int (*set_parity)(char *parity);
+  int (*set_flow_control)(int mode);
+  UartStats *stats;
+} UartDriver;
+
+extern const UartDriver *uartPorts[UART_PORT_COUNT];
+
+/* Port selection */
+int uart_select_console(int port);
+int uart_select_log(int port);
+int uart_console_port();
+int uart_log_port();
+void uart_reset_stats(int port);
+
+/* Function prototypes, operating on the console port */
+void uart_init();
+void uart_sendc(char c);
+char uart_getc();
+void uart_puts(char *s);
+void uart_write(const char *s, size_t len);
+void uart_hex(unsigned int num);
+void uart_dec(int num);
+void uart_flush();
+void uart_poll();
+int uart_getc_timeout(char *c, unsigned int msec);
+
+int uart_set_baud_rate(unsigned int baud_rate);
+int uart_baud_supported(unsigned int baud_rate);
+unsigned int uart_get_baud_rate();
+int uart_set_data_bits(unsigned char data_bits);
+int uart_set_stop_bits(unsigned char stop_bits);
+int uart_set_parity(char *parity);
+int uart_set_flow_control(int mode);
+
+/* Output to a specific port */
+void uart_port_puts(int port, char *s);
+void uart_log_puts(char *s);
+
+#endif
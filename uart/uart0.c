@@ -1,53 +1,86 @@
 #include "uart0.h"
 #include "../kernel/mbox.h"
 #include "../kernel/string.h"
+#include "../kernel/gpio.h"
+#include "../kernel/timer.h"
+#include "../kernel/dlog.h"
+#include "../kernel/log.h"
+#include "../kernel/lock.h"
+
+static unsigned int uart0_clock = 0;
+static unsigned int uart0_baud = UART_BAUD_DEFAULT;
+
+UartStats uart0_stats;
+
+/* Receive ring, filled from the RX FIFO by uart0_service() */
+static volatile char rxRing[UART0_RX_RING_SIZE];
+static volatile unsigned int rxHead = 0; // written by uart0_service()
+static volatile unsigned int rxTail = 0; // written by the reader
+
+/* Only this core (the one that ran uart0_init, the shell's) reads DR and
+   moves rxHead. Any core may transmit, txLock keeps the FIFO check, the DR
+   write and the TX counters together. */
+static unsigned int rxCore = 0;
+static CoreLock txLock;
+
+/* Flow control state */
+static int uart0_primary = 1;
+static int flowMode = UART_FLOW_NONE;
+static int rxThrottled = 0;              // host told to stop (RTS deasserted / XOFF sent)
+static volatile int txPaused = 0;        // host sent XOFF
 
 /**
- * Set baud rate and characteristics (115200 8N1) and map to GPIO
+ * Set the UART reference clock through the mailbox
  */
-void uart_init()
+static void uart0_set_clock(unsigned int rate)
 {
-    unsigned int r;
-
-	/* Turn off UART0 */
-	UART0_CR = 0x0;
+	if (rate == uart0_clock)
+		return;
 
- 
-	/* NEW: set up UART clock for consistent divisor values 
-	--> may not work with QEMU, but will work with real board */ 
 	mBuf[0] = 9*4; 
 	mBuf[1] = MBOX_REQUEST; 
 	mBuf[2] = MBOX_TAG_SETCLKRATE; // set clock rate 
 	mBuf[3] = 12; // Value buffer size in bytes
 	mBuf[4] = 0; // REQUEST CODE = 0
 	mBuf[5] = 2; // clock id: UART clock
-	mBuf[6] = 4000000;     // rate: 4Mhz 
+	mBuf[6] = rate;        // rate in Hz
 	mBuf[7] = 0;           // clear turbo 
 	mBuf[8] = MBOX_TAG_LAST; 
 	mbox_call(ADDR(mBuf), MBOX_CH_PROP);
+	uart0_clock = rate;
+}
+
+/**
+ * Set baud rate and characteristics (115200 8N1) and map to GPIO
+ * primary: map to the console pins (GPIO14/15) instead of GPIO32/33
+ */
+void uart0_init(int primary)
+{
+	uart0_primary = primary;
+	rxCore = cpu_id();
 
-	/* Setup GPIO pins 14 and 15 */
-
-	/* Set GPIO14 and GPIO15 to be pl011 TX/RX which is ALT0	*/
-	r = GPFSEL1;
-	r &=  ~((7 << 12) | (7 << 15)); //clear bits 17-12 (FSEL15, FSEL14)
-	r |= (0b100 << 12)|(0b100 << 15);   //Set value 0b100 (select ALT0: TXD0/RXD0)
-	GPFSEL1 = r;
-	
-	/* enable GPIO 14, 15 */
-#ifdef RPI3 //RBP3
-	GPPUD = 0;            //No pull up/down control
-	//Toogle clock to flush GPIO setup
-	r = 150; while(r--) { asm volatile("nop"); } //waiting 150 cycles
-	GPPUDCLK0 = (1 << 14)|(1 << 15); //enable clock for GPIO 14, 15
-	r = 150; while(r--) { asm volatile("nop"); } //waiting 150 cycles
-	GPPUDCLK0 = 0;        // flush GPIO setup
-
-#else //RPI4
-	r = GPIO_PUP_PDN_CNTRL_REG0;
-	r &= ~((3 << 28) | (3 << 30)); //No resistor is selected for GPIO 14, 15
-	GPIO_PUP_PDN_CNTRL_REG0 = r;
-#endif
+	/* Turn off UART0 */
+	UART0_CR = 0x0;
+
+ 
+	/* NEW: set up UART clock for consistent divisor values 
+	--> may not work with QEMU, but will work with real board */ 
+	uart0_set_clock(UART0_CLOCK_DEFAULT);
+
+	/* Map TX/RX: the console port gets GPIO14/15 (ALT0),
+	   the second port GPIO32/33 (ALT3) */
+	if (primary) {
+		gpio_set_function(14, GPIO_FUNC_ALT0);
+		gpio_set_function(15, GPIO_FUNC_ALT0);
+		gpio_disable_pull(14);
+		gpio_disable_pull(15);
+	}
+	else {
+		gpio_set_function(32, GPIO_FUNC_ALT3);
+		gpio_set_function(33, GPIO_FUNC_ALT3);
+		gpio_disable_pull(32);
+		gpio_disable_pull(33);
+	}
 
 	/* Mask all interrupts. */
 	UART0_IMSC = 0;
@@ -77,143 +110,306 @@ void uart_init()
 	/* Defaults for other bit are No parity, 1 stop bit */
 	UART0_LCRH = UART0_LCRH_FEN | UART0_LCRH_WLEN_8BIT;
 
+	/* FIFO trigger levels, RX 1/2 and TX 1/2 (same as the reset value) */
+	uart0_set_fifo_levels(UART0_IFLS_1_2, UART0_IFLS_1_2);
+
 	/* Enable UART0, receive, and transmit */
 	UART0_CR = 0x301;     // enable Tx, Rx, FIFO
 }
 
 
 
+static void uart0_throttle(int throttle);
+
+/**
+ * Move received bytes from the RX FIFO into the ring. The receiver is polled
+ * with the PL011 interrupts masked; the raw status still decides when a batch
+ * is ready, so IFLS and the receive timeout set the batch size:
+ *  - RX: level reached (RXRIS) or data sat in the FIFO for 32 bit periods (RTRIS)
+ * Both raw bits clear themselves once the FIFO is drained.
+ * Does nothing on other cores than rxCore.
+ */
+void uart0_service() {
+	if (cpu_id() != rxCore || !(UART0_RIS & (UART0_IMSC_RX | UART0_IMSC_RT)))
+		return;
+
+	uart0_stats.rx_polls++;
+	while (!(UART0_FR & UART0_FR_RXFE) && rxHead - rxTail < UART0_RX_RING_SIZE) {
+		/* DR carries the framing, parity and break status of each byte */
+		unsigned int data = UART0_DR;
+
+		if (data & UART0_DR_FE)
+			uart0_stats.framing_errors++;
+		if (data & UART0_DR_PE)
+			uart0_stats.parity_errors++;
+		if (data & UART0_DR_BE)
+			uart0_stats.break_errors++;
+
+		uart0_stats.rx_bytes++;
+
+		/* In software flow control XON/XOFF from the host gate our transmitter */
+		if (flowMode == UART_FLOW_XONXOFF && ((data & 0xFF) == UART_XOFF || (data & 0xFF) == UART_XON)) {
+			txPaused = (data & 0xFF) == UART_XOFF;
+			if (txPaused)
+				uart0_stats.remote_pauses++;
+			continue;
+		}
+
+		rxRing[rxHead % UART0_RX_RING_SIZE] = (unsigned char) data;
+		rxHead++;
+	}
+
+	/* Overrun is flagged in RSRECR as soon as a byte is lost, count it once and clear */
+	if (UART0_RSRECR & UART0_RSRECR_OE) {
+		uart0_stats.overruns++;
+		UART0_RSRECR = 0;
+	}
+
+	if (rxHead - rxTail > uart0_stats.rx_peak)
+		uart0_stats.rx_peak = rxHead - rxTail;
+
+	/* Throttle the host before the ring fills up */
+	if (!rxThrottled && rxHead - rxTail >= UART0_RX_HIGH_WATERMARK)
+		uart0_throttle(1);
+}
+
+/**
+ * Write a byte straight to the FIFO, bypassing the XOFF gate (used for XON/XOFF)
+ */
+static void uart0_send_raw(char c) {
+	lock_acquire(&txLock);
+	while (UART0_FR & UART0_FR_TXFF) {
+		asm volatile("nop");
+	}
+	UART0_DR = c;
+	uart0_stats.tx_bytes++;
+	lock_release(&txLock);
+}
+
+/**
+ * Ask the host to stop (throttle = 1) or resume sending
+ */
+static void uart0_throttle(int throttle) {
+	if (flowMode == UART_FLOW_RTSCTS) {
+		/* Deassert RTS ourselves while the ring is full. Otherwise RTSEN lets
+		   the hardware drop it when the FIFO reaches the RX trigger level, the
+		   backstop for stretches where nothing services the receiver. */
+		if (throttle)
+			UART0_CR &= ~(UART0_CR_RTSEN | UART0_CR_RTS);
+		else
+			UART0_CR |= UART0_CR_RTSEN | UART0_CR_RTS;
+	}
+	else if (flowMode == UART_FLOW_XONXOFF) {
+		uart0_send_raw(throttle ? UART_XOFF : UART_XON);
+	}
+	else {
+		return;
+	}
+
+	rxThrottled = throttle;
+	if (throttle)
+		uart0_stats.throttles++;
+	DLOG("uart0 throttle=%u ring=%u", throttle, rxHead - rxTail);
+}
+
+/**
+ * Take one byte out of the receive ring, resuming the host below the low watermark
+ */
+static char uart0_take() {
+	char c = rxRing[rxTail % UART0_RX_RING_SIZE];
+
+	rxTail++;
+	if (rxThrottled && rxHead - rxTail <= UART0_RX_LOW_WATERMARK)
+		uart0_throttle(0);
+	return c;
+}
+
 /**
  * Send a character
  */
-void uart_sendc(char c) {
+void uart0_sendc(char c) {
+	unsigned long paused = 0;
+
+	/* Keep receiving while output runs, so input that arrives during a long
+	   command lands in the ring and throttles the host instead of overrunning */
+	uart0_service();
+
+	/* Hold off while the host has sent XOFF. rxCore keeps receiving so it sees
+	   the XON, any other core waits for rxCore to clear txPaused. */
+	if (txPaused) {
+		unsigned long start = timer_ticks();
+
+		while (txPaused && flowMode == UART_FLOW_XONXOFF) {
+			uart0_service();
+		}
+		paused = timer_ticks() - start;
+	}
+
+	lock_acquire(&txLock);
 
     /* Check Flags Register */
-	/* And wait until transmitter is not full */
-	do {
-		asm volatile("nop");
-	} while (UART0_FR & UART0_FR_TXFF);
+	/* If the transmitter is full, wait until TXRIS says the FIFO drained to
+	   the TX trigger level and refill from there */
+	if (UART0_FR & UART0_FR_TXFF) {
+		unsigned long start = timer_ticks();
+
+		do {
+			asm volatile("nop");
+		} while (!(UART0_RIS & UART0_IMSC_TX) && (UART0_FR & UART0_FR_TXFF));
+		uart0_stats.tx_waits++;
+		paused += timer_ticks() - start;
+	}
 
 	/* Write our data byte out to the data register */
 	UART0_DR = c ;
+	uart0_stats.tx_bytes++;
+	uart0_stats.tx_stall_ticks += paused;
+	lock_release(&txLock);
 }
 
 /**
  * Receive a character
  */
-char uart_getc() {
+char uart0_getc() {
     char c = 0;
 
-    /* Check Flags Register */
-    /* Wait until Receiver is not empty
-     * (at least one byte data in receive fifo)*/
-	do {
-		asm volatile("nop");
-    } while ( UART0_FR & UART0_FR_RXFE );
+    /* Wait until the receive ring holds at least one byte */
+	while (rxHead == rxTail) {
+		uart0_service();
+	}
 
     /* read it and return */
-    c = (unsigned char) (UART0_DR);
+    c = uart0_take();
 
     /* convert carriage return to newline */
     return (c == '\r' ? '\n' : c);
 }
 
-
 /**
- * Display a string
+ * Program the RX/TX FIFO trigger levels (UART0_IFLS_1_8 .. UART0_IFLS_7_8)
  */
-void uart_puts(char *s) {
-    while (*s) {
-        /* convert newline to carriage return + newline */
-        if (*s == '\n')
-            uart_sendc('\r');
-        uart_sendc(*s++);
-    }
+int uart0_set_fifo_levels(unsigned int rx_level, unsigned int tx_level) {
+	if (rx_level > UART0_IFLS_7_8 || tx_level > UART0_IFLS_7_8)
+		return 0;
+
+	UART0_IFLS = (rx_level << UART0_IFLS_RX_SHIFT) | (tx_level << UART0_IFLS_TX_SHIFT);
+	return 1;
 }
 
+void uart0_get_fifo_levels(unsigned int *rx_level, unsigned int *tx_level) {
+	unsigned int ifls = UART0_IFLS;
 
-/**
-* Display a value in hexadecimal format
-*/
-void uart_hex(unsigned int num) {
-	uart_puts("0x");
-	for (int pos = 28; pos >= 0; pos = pos - 4) {
-
-		// Get highest 4-bit nibble
-		char digit = (num >> pos) & 0xF;
-
-		/* Convert to ASCII code */
-		// 0-9 => '0'-'9', 10-15 => 'A'-'F'
-		digit += (digit > 9) ? (-10 + 'A') : '0';
-		uart_sendc(digit);
-	}
+	*rx_level = (ifls >> UART0_IFLS_RX_SHIFT) & 7;
+	*tx_level = (ifls >> UART0_IFLS_TX_SHIFT) & 7;
 }
 
-/*
-**
-* Display a value in decimal format
-*/
-void uart_dec(int num)
-{
-	//A string to store the digit characters
-	char str[33] = "";
-
-	//Calculate the number of digits
-	int len = 1;
-	int temp = num;
-	while (temp >= 10){
-		len++;
-		temp = temp / 10;
-	}
+/**
+ * Wait until the transmit FIFO is empty and the last character has left the shifter
+ */
+void uart0_flush() {
+	do {
+		asm volatile("nop");
+	} while (!(UART0_FR & UART0_FR_TXFE) || (UART0_FR & UART0_FR_BUSY));
+}
 
-	//Store into the string and print out
-	for (int i = 0; i < len; i++){
-		int digit = num % 10; //get last digit
-		num = num / 10; //remove last digit from the number
-		str[len - (i + 1)] = digit + '0';
+/**
+ * Receive a raw character, giving up after msec milliseconds.
+ * Returns 1 if a character was read, 0 on timeout.
+ */
+int uart0_getc_timeout(char *c, unsigned int msec) {
+	unsigned long start = timer_ticks();
+	unsigned long wait = (timer_freq() * msec) / 1000;
+
+	while (rxHead == rxTail) {
+		if (timer_ticks() - start >= wait)
+			return 0;
+		uart0_service();
 	}
-	str[len] = '\0';
 
-	uart_puts(str);
+	*c = uart0_take();
+	return 1;
 }
 
-void uart_set_baud_rate(unsigned int baud) {
-  unsigned int baud_divisor = 4000000 / (16 * baud);
-  unsigned int fractional_part = ((4000000.0 / (16 * baud)) - baud_divisor) * 64 + 0.5;
+/**
+ * Reprogram the baud rate divisors.
+ * Returns 1 on success, 0 if the rate can't be generated (nothing is changed then).
+ */
+int uart0_set_baud_rate(unsigned int baud) {
+	if (baud < UART0_BAUD_MIN || baud > UART0_BAUD_MAX)
+		return 0;
+
+	/* The 4MHz clock gives exact divisors up to 115200, faster rates need
+	   a faster reference clock (max baud = UART_CLOCK / 16) */
+	unsigned int clock = (baud > UART_BAUD_DEFAULT) ? UART0_CLOCK_FAST : UART0_CLOCK_DEFAULT;
+
+	/* Divider * 64 rounded to nearest: top bits are IBRD, low 6 bits are FBRD */
+	unsigned int divider = (4 * clock + baud / 2) / baud;
+	unsigned int lcrh = UART0_LCRH;
+
+	/* 1. Let the current transmission finish */
+	uart0_flush();
+
+	/* 2. Disable the UART */
+	UART0_CR &= ~UART0_CR_UARTEN;
+
+	/* 3. Flush the FIFOs by clearing FEN */
+	UART0_LCRH = lcrh & ~UART0_LCRH_FEN;
+
+	/* 4. Reprogram the clock and divisors, a write to LCRH latches IBRD/FBRD */
+	uart0_set_clock(clock);
+	UART0_IBRD = divider >> 6;
+	UART0_FBRD = divider & 0x3F;
+	UART0_LCRH = lcrh;
 
-  UART0_IBRD = baud_divisor;
-  UART0_FBRD = fractional_part;
+	/* 5. Enable the UART */
+	UART0_CR |= UART0_CR_UARTEN;
+
+	uart0_baud = baud;
+	LOG_DEBUG(LOG_MOD_UART, "baud %u: clock %u IBRD %u FBRD %u", baud, clock, divider >> 6, divider & 0x3F);
+	return 1;
+}
+
+unsigned int uart0_get_baud_rate() {
+	return uart0_baud;
 }
 
-void uart_set_data_bits(unsigned char data_bits) {
-  UART0_LCRH &= ~(3 << 5); // Clear the WLEN bits
+int uart0_set_data_bits(unsigned char data_bits) {
+  unsigned int wlen;
+
   switch (data_bits) {
     case 5:
-      UART0_LCRH |= UART0_LCRH_WLEN_5BIT;
+      wlen = UART0_LCRH_WLEN_5BIT;
       break;
     case 6:
-      UART0_LCRH |= UART0_LCRH_WLEN_6BIT;
+      wlen = UART0_LCRH_WLEN_6BIT;
       break;
     case 7:
-      UART0_LCRH |= UART0_LCRH_WLEN_7BIT;
+      wlen = UART0_LCRH_WLEN_7BIT;
       break;
     case 8:
-    default:
-      UART0_LCRH |= UART0_LCRH_WLEN_8BIT;
+      wlen = UART0_LCRH_WLEN_8BIT;
       break;
+    default:
+      return 0;
   }
+  UART0_LCRH = (UART0_LCRH & ~(3 << 5)) | wlen; // Replace the WLEN bits
+  return 1;
 }
 
-void uart_set_stop_bits(unsigned char stop_bits) {
-  if(stop_bits == 2) {
+int uart0_set_stop_bits(unsigned char stop_bits) {
+  if (stop_bits == 2) {
     UART0_LCRH |= UART0_LCRH_STP2;  // Enable two stop bits
   } 
-	else {
-    UART0_LCRH &= ~UART0_LCRH_STP2; // Default to one stop bit
+	else if (stop_bits == 1) {
+    UART0_LCRH &= ~UART0_LCRH_STP2; // One stop bit
   }
+	else {
+		return 0;
+	}
+	return 1;
 }
 
-void uart_set_parity(char *parity) {
+int uart0_set_parity(char *parity) {
   if (strcmp(parity, "none") == 0) {
     UART0_LCRH &= ~UART0_LCRH_PEN; // Disable parity
   } 
@@ -224,14 +420,57 @@ void uart_set_parity(char *parity) {
     UART0_LCRH |= UART0_LCRH_PEN;
     UART0_LCRH &= ~UART0_LCRH_EPS; // Enable odd parity
   }
+	else {
+		return 0;
+	}
+	return 1;
 }
 
-void uart_enable_handshaking() {
-  UART0_CR |= (UART0_CR_RTSEN | UART0_CR_CTSEN);  // Enable both RTS and CTS
-  uart_puts("Handshaking enabled.\n");
+/**
+ * Select the flow control mode:
+ *  UART_FLOW_RTSCTS  - CTS gates our transmitter in hardware. RTS is dropped
+ *                      at the receive ring's high watermark, and by RTSEN at
+ *                      the RX FIFO trigger level while the ring has room
+ *  UART_FLOW_XONXOFF - XOFF/XON sent at the watermarks, honoured when received
+ */
+int uart0_set_flow_control(int mode) {
+	if (mode != UART_FLOW_NONE && mode != UART_FLOW_RTSCTS && mode != UART_FLOW_XONXOFF)
+		return 0;
+
+	UART0_CR &= ~(UART0_CR_RTSEN | UART0_CR_CTSEN);
+	flowMode = mode;
+	rxThrottled = 0;
+	txPaused = 0;
+
+	if (mode == UART_FLOW_RTSCTS) {
+		/* CTS0/RTS0 are ALT3 on GPIO16/17 next to the console pins, GPIO30/31 otherwise */
+		unsigned int cts = uart0_primary ? 16 : 30;
+
+		gpio_set_function(cts, GPIO_FUNC_ALT3);
+		gpio_set_function(cts + 1, GPIO_FUNC_ALT3);
+		UART0_CR |= UART0_CR_CTSEN | UART0_CR_RTSEN | UART0_CR_RTS;
+
+		if (rxHead - rxTail >= UART0_RX_HIGH_WATERMARK)
+			uart0_throttle(1);
+	}
+	return 1;
 }
 
-void uart_disable_handshaking() {
-  UART0_CR &= ~(UART0_CR_RTSEN | UART0_CR_CTSEN); // Disable both RTS and CTS
-  uart_puts("Handshaking disabled.\n");
-}
\ No newline at end of file
+const UartDriver uart0_driver = {
+  .name = "PL011 (UART0)",
+  .init = uart0_init,
+  .sendc = uart0_sendc,
+  .getc = uart0_getc,
+  .getc_timeout = uart0_getc_timeout,
+  .flush = uart0_flush,
+  .poll = uart0_service,
+  .set_baud_rate = uart0_set_baud_rate,
+  .baud_min = UART0_BAUD_MIN,
+  .baud_max = UART0_BAUD_MAX,
+  .get_baud_rate = uart0_get_baud_rate,
+  .set_data_bits = uart0_set_data_bits,
+  .set_stop_bits = uart0_set_stop_bits,
+  .set_parity = uart0_set_parity,
+  .set_flow_control = uart0_set_flow_control,
+  .stats = &uart0_stats,
+};
@@ -1,10 +1,15 @@
 #include "../kernel/gpio.h"
+#include "uart.h"
 
 /* PL011 UART (UART0) registers */
 #define UART0_BASE	(MMIO_BASE + 0x201000)
 
 /* DR = Data register */
 #define UART0_DR	(* (volatile unsigned int*)(UART0_BASE + 0x00))
+#define UART0_DR_OE	(1<<11)	/* OE = Overrun error */
+#define UART0_DR_BE	(1<<10)	/* BE = Break error */
+#define UART0_DR_PE	(1<<9)	/* PE = Parity error */
+#define UART0_DR_FE	(1<<8)	/* FE = Framing error */
 /* On write, write 8-bits to send */
 /* On receive, get 12-bits:       */
 /*    Overrun Error == Overflowed FIFO */
@@ -16,6 +21,7 @@
 /* RSRECR = Receive Status Register */
 /*  Has same 4 bits of error as in DR */
 #define UART0_RSRECR (* (volatile unsigned int*)(UART0_BASE + 0x04))
+#define UART0_RSRECR_OE	(1<<3)	/* OE = Overrun error, cleared by writing RSRECR */
 
 /* FR = Flags Register */
 #define UART0_FR	(* (volatile unsigned int*)(UART0_BASE + 0x18))
@@ -84,6 +90,13 @@
 /*   5 - 3 = RXIFLSEL = 000=1/8, 001=1/4, 010=1/2, 011=3/4 100=7/8 */
 /*   2 - 0 = TXIFLSEL = 000=1/8, 001=1/4, 010=1/2, 011=3/4 100=7/8 */
 #define UART0_IFLS	(* (volatile unsigned int*)(UART0_BASE + 0x34))
+#define UART0_IFLS_RX_SHIFT	3
+#define UART0_IFLS_TX_SHIFT	0
+#define UART0_IFLS_1_8	0
+#define UART0_IFLS_1_4	1
+#define UART0_IFLS_1_2	2
+#define UART0_IFLS_3_4	3
+#define UART0_IFLS_7_8	4
 /* IMSRC = Interrupt Mask Set/Clear */
 /*   10 = OEIM = Overrun Interrupt Mask */
 /*    9 = BEIM = Break Interrupt Mask */
@@ -149,17 +162,37 @@
 #define UART0_TDR	(* (volatile unsigned int*)(UART0_BASE + 0x8C))
 
 
+/* Reference clock set through the mailbox */
+#define UART0_CLOCK_DEFAULT	4000000		/* 4MHz, exact divisors up to 115200 */
+#define UART0_CLOCK_FAST	48000000	/* 48MHz, used above 115200 */
+
+/* Receive ring size, must be a power of two */
+#define UART0_RX_RING_SIZE	1024
+/* Flow control watermarks on the receive ring */
+#define UART0_RX_HIGH_WATERMARK	(UART0_RX_RING_SIZE * 3 / 4)
+#define UART0_RX_LOW_WATERMARK	(UART0_RX_RING_SIZE / 4)
+
+#define UART0_BAUD_MIN		300
+#define UART0_BAUD_MAX		(UART0_CLOCK_FAST / 16)
+
 /* Function prototypes */
-void uart_init();
-void uart_sendc(char c);
-char uart_getc();
-void uart_puts(char *s);
-void uart_hex(unsigned int num);
-void uart_dec(int num);
+void uart0_init(int primary);
+void uart0_sendc(char c);
+char uart0_getc();
+void uart0_flush();
+int uart0_getc_timeout(char *c, unsigned int msec);
+
+int uart0_set_baud_rate(unsigned int baud_rate);
+unsigned int uart0_get_baud_rate();
+int uart0_set_data_bits(unsigned char data_bits);
+int uart0_set_stop_bits(unsigned char stop_bits);
+int uart0_set_parity(char *parity);
+int uart0_set_flow_control(int mode);
+
+void uart0_service();
+int uart0_set_fifo_levels(unsigned int rx_level, unsigned int tx_level);
+void uart0_get_fifo_levels(unsigned int *rx_level, unsigned int *tx_level);
+
+extern UartStats uart0_stats;
 
-void uart_set_baud_rate(unsigned int baud_rate);
-void uart_set_data_bits(unsigned char data_bits);
-void uart_set_stop_bits(unsigned char stop_bits);
-void uart_set_parity(char *parity);
-void uart_enable_handshaking();
-void uart_disable_handshaking();
\ No newline at end of file
+extern const UartDriver uart0_driver;
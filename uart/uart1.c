@@ -1,12 +1,15 @@
 #include "uart1.h"
+#include "../kernel/string.h"
+#include "../kernel/timer.h"
+
+UartStats uart1_stats;
 
 /**
  * Set baud rate and characteristics (115200 8N1) and map to GPIO
+ * primary: map to the console pins (GPIO14/15) instead of GPIO32/33
  */
-void uart_init()
+void uart1_init(int primary)
 {
-    unsigned int r;
-
     /* initialize UART */
     AUX_ENABLE |= 1;     //enable mini UART (UART1) 
     AUX_MU_CNTL = 0;	 //stop transmitter and receiver
@@ -19,134 +22,146 @@ void uart_init()
     /* Note: refer to page 11 of ARM Peripherals guide for baudrate configuration 
     (system_clk_freq is 250MHz by default) */
 
-    /* map UART1 to GPIO pins 14 and 15 */
-    r = GPFSEL1;
-    r &=  ~( (7 << 12)|(7 << 15) ); //clear bits 17-12 (FSEL15, FSEL14)
-    r |= (0b010 << 12)|(0b010 << 15);   //set value 0b010 (select ALT5: TXD1/RXD1)
-    GPFSEL1 = r;
-
-	/* enable GPIO 14, 15 */
-#ifdef RPI3 //RPI3
-	GPPUD = 0;            //No pull up/down control
-	//Toogle clock to flush GPIO setup
-	r = 150; while(r--) { asm volatile("nop"); } //waiting 150 cycles
-	GPPUDCLK0 = (1 << 14)|(1 << 15); //enable clock for GPIO 14, 15
-	r = 150; while(r--) { asm volatile("nop"); } //waiting 150 cycles
-	GPPUDCLK0 = 0;        // flush GPIO setup
-
-#else //RPI4
-	r = GPIO_PUP_PDN_CNTRL_REG0;
-	r &= ~((3 << 28) | (3 << 30)); //No resistor is selected for GPIO 14, 15
-	GPIO_PUP_PDN_CNTRL_REG0 = r;
-#endif
+    /* Map TX/RX: the console port gets GPIO14/15,
+       the second port GPIO32/33 (both ALT5: TXD1/RXD1) */
+    if (primary) {
+        gpio_set_function(14, GPIO_FUNC_ALT5);
+        gpio_set_function(15, GPIO_FUNC_ALT5);
+        gpio_disable_pull(14);
+        gpio_disable_pull(15);
+    }
+    else {
+        gpio_set_function(32, GPIO_FUNC_ALT5);
+        gpio_set_function(33, GPIO_FUNC_ALT5);
+        gpio_disable_pull(32);
+        gpio_disable_pull(33);
+    }
 
     AUX_MU_CNTL = 3;      //enable transmitter and receiver (Tx, Rx)
 }
 
+/**
+ * Check for received data, LSR bit 1 (receiver overrun) clears when LSR is read
+ */
+static int uart1_rx_ready() {
+    unsigned int lsr = AUX_MU_LSR;
+
+    if (lsr & 0x02)
+        uart1_stats.overruns++;
+    return lsr & 0x01;
+}
+
 /**
  * Send a character
  */
-void uart_sendc(char c) {
+void uart1_sendc(char c) {
     // wait until transmitter is empty
-    do {
-    	asm volatile("nop");
-    } while ( !(AUX_MU_LSR & 0x20) );
+    if ( !(AUX_MU_LSR & 0x20) ) {
+        unsigned long start = timer_ticks();
+
+        do {
+        	asm volatile("nop");
+        } while ( !(AUX_MU_LSR & 0x20) );
+        uart1_stats.tx_stall_ticks += timer_ticks() - start;
+    }
 
     // write the character to the buffer 
     AUX_MU_IO = c;
+    uart1_stats.tx_bytes++;
 }
 
 /**
  * Receive a character
  */
-char uart_getc() {
+char uart1_getc() {
     char c;
 
     // wait until data is ready (one symbol)
-    do {
+    while ( !uart1_rx_ready() ) {
     	asm volatile("nop");
-    } while ( !(AUX_MU_LSR & 0x01) );
+    }
 
     // read it and return
     c = (unsigned char)(AUX_MU_IO);
+    uart1_stats.rx_bytes++;
 
     // convert carriage return to newline character
     return (c == '\r' ? '\n' : c);
 }
 
 /**
- * Display a string
+ * Wait until the transmitter is idle
  */
-void uart_puts(char *s) {
-    while (*s) {
-        // convert newline to carriage return + newline
-        if (*s == '\n')
-            uart_sendc('\r');
-        uart_sendc(*s++);
-    }
+void uart1_flush() {
+    do {
+    	asm volatile("nop");
+    } while ( !(AUX_MU_LSR & 0x40) );
 }
 
-
 /**
-* Display a value in hexadecimal format
-*/
-void uart_hex(unsigned int num) {
-	uart_puts("0x");
-	for (int pos = 28; pos >= 0; pos = pos - 4) {
-
-		// Get highest 4-bit nibble
-		char digit = (num >> pos) & 0xF;
-
-		/* Convert to ASCII code */
-		// 0-9 => '0'-'9', 10-15 => 'A'-'F'
-		digit += (digit > 9) ? (-10 + 'A') : '0';
-		uart_sendc(digit);
-	}
-}
+ * Receive a raw character, giving up after msec milliseconds.
+ * Returns 1 if a character was read, 0 on timeout.
+ */
+int uart1_getc_timeout(char *c, unsigned int msec) {
+    unsigned long start = timer_ticks();
+    unsigned long wait = (timer_freq() * msec) / 1000;
 
-/*
-**
-* Display a value in decimal format
-*/
-void uart_dec(int num)
-{
-	//A string to store the digit characters
-	char str[33] = "";
-
-	//Calculate the number of digits
-	int len = 1;
-	int temp = num;
-	while (temp >= 10){
-		len++;
-		temp = temp / 10;
-	}
-
-	//Store into the string and print out
-	for (int i = 0; i < len; i++){
-		int digit = num % 10; //get last digit
-		num = num / 10; //remove last digit from the number
-		str[len - (i + 1)] = digit + '0';
-	}
-	str[len] = '\0';
-
-	uart_puts(str);
-}
+    while ( !uart1_rx_ready() ) {
+        if (timer_ticks() - start >= wait)
+            return 0;
+    }
 
-void uart_set_baud_rate(unsigned int baud_rate){
+    *c = (unsigned char)(AUX_MU_IO);
+    uart1_stats.rx_bytes++;
+    return 1;
+}
 
+/**
+ * The divisor follows the VPU core clock, which the firmware may change, so
+ * the rate stays at the 115200 programmed in uart1_init: no set_baud_rate.
+ */
+unsigned int uart1_get_baud_rate(){
+	return UART_BAUD_DEFAULT;
 }
-void uart_set_data_bits(unsigned char data_bits){
 
+/**
+ * 7 or 8 data bits, LCR bit 0 (bit 1 is set as well on the RPi3)
+ */
+int uart1_set_data_bits(unsigned char data_bits){
+	if (data_bits != 7 && data_bits != 8)
+		return 0;
+	AUX_MU_LCR = (data_bits == 8) ? 3 : 2;
+	return 1;
 }
-void uart_set_stop_bits(unsigned char stop_bits){
 
+/**
+ * The mini UART always sends one stop bit and has no parity, only those are accepted
+ */
+int uart1_set_stop_bits(unsigned char stop_bits){
+	return stop_bits == 1;
 }
-void uart_set_parity(char *parity){
 
+int uart1_set_parity(char *parity){
+	return strcmp(parity, "none") == 0;
 }
-void uart_enable_handshaking(){
 
+int uart1_set_flow_control(int mode){
+	return mode == UART_FLOW_NONE;
 }
-void uart_disable_handshaking(){
-	
-}
\ No newline at end of file
+
+const UartDriver uart1_driver = {
+  .name = "mini UART (UART1)",
+  .init = uart1_init,
+  .sendc = uart1_sendc,
+  .getc = uart1_getc,
+  .getc_timeout = uart1_getc_timeout,
+  .flush = uart1_flush,
+  .baud_min = UART_BAUD_DEFAULT,  // fixed at boot
+  .baud_max = UART_BAUD_DEFAULT,
+  .get_baud_rate = uart1_get_baud_rate,
+  .set_data_bits = uart1_set_data_bits,
+  .set_stop_bits = uart1_set_stop_bits,
+  .set_parity = uart1_set_parity,
+  .set_flow_control = uart1_set_flow_control,
+  .stats = &uart1_stats,
+};
@@ -1,4 +1,5 @@
 #include "../kernel/gpio.h"
+#include "uart.h"
 
 /* Auxilary mini UART (UART1) registers */
 #define AUX_ENABLE      (* (volatile unsigned int*)(MMIO_BASE+0x00215004))
@@ -15,16 +16,17 @@
 #define AUX_MU_BAUD     (* (volatile unsigned int*)(MMIO_BASE+0x00215068))
 
 /* Function prototypes */
-void uart_init();
-void uart_sendc(char c);
-char uart_getc();
-void uart_puts(char *s);
-void uart_hex(unsigned int num);
-void uart_dec(int num);
+void uart1_init(int primary);
+void uart1_sendc(char c);
+char uart1_getc();
+void uart1_flush();
+int uart1_getc_timeout(char *c, unsigned int msec);
 
-void uart_set_baud_rate(unsigned int baud_rate);
-void uart_set_data_bits(unsigned char data_bits);
-void uart_set_stop_bits(unsigned char stop_bits);
-void uart_set_parity(char *parity);
-void uart_enable_handshaking();
-void uart_disable_handshaking();
\ No newline at end of file
+unsigned int uart1_get_baud_rate();
+int uart1_set_data_bits(unsigned char data_bits);
+int uart1_set_stop_bits(unsigned char stop_bits);
+int uart1_set_parity(char *parity);
+int uart1_set_flow_control(int mode);
+
+extern const UartDriver uart1_driver;
+extern UartStats uart1_stats;